@@ -27,6 +27,7 @@
 #include <video/sh_mobile_lcdc.h>
 #include <asm/io.h>
 #include <asm/clock.h>
+#include <asm/dma-sh.h>
 #include <asm/suspend.h>
 #include <cpu/sh7723.h>
 
@@ -127,7 +128,12 @@ static struct resource nand_flash_resources[] = {
 		.start	= 0xa4530000,
 		.end	= 0xa45300ff,
 		.flags	= IORESOURCE_MEM,
-	}
+	},
+	[1] = {
+		.start	= 109,	/* FLTENDI */
+		.end	= 109,
+		.flags	= IORESOURCE_IRQ,
+	},
 };
 
 static struct sh_flctl_platform_data nand_flash_data = {
@@ -135,6 +141,8 @@ static struct sh_flctl_platform_data nand_flash_data = {
 	.nr_parts	= ARRAY_SIZE(nand_partition_info),
 	.flcmncr_val	= FCKSEL_E | TYPESEL_SET | NANWF_E,
 	.has_hwecc	= 1,
+	.dma_slave_tx	= SHDMA_SLAVE_FLCTL0_TX,
+	.dma_slave_rx	= SHDMA_SLAVE_FLCTL0_RX,
 };
 
 static struct platform_device nand_flash_device = {
@@ -34,6 +34,7 @@
 #include <asm/heartbeat.h>
 #include <asm/sh_eth.h>
 #include <asm/clock.h>
+#include <asm/dma-sh.h>
 #include <asm/suspend.h>
 #include <cpu/sh7724.h>
 
@@ -442,7 +443,9 @@ static void sdhi0_set_pwr(struct platform_device *pdev, int state)
 }
 
 static struct sh_mobile_sdhi_info sdhi0_info = {
-	.set_pwr = sdhi0_set_pwr,
+	.dma_slave_tx	= SHDMA_SLAVE_SDHI0_TX,
+	.dma_slave_rx	= SHDMA_SLAVE_SDHI0_RX,
+	.set_pwr	= sdhi0_set_pwr,
 };
 
 static struct resource sdhi0_resources[] = {
@@ -478,7 +481,9 @@ static void sdhi1_set_pwr(struct platform_device *pdev, int state)
 }
 
 static struct sh_mobile_sdhi_info sdhi1_info = {
-	.set_pwr = sdhi1_set_pwr,
+	.dma_slave_tx	= SHDMA_SLAVE_SDHI1_TX,
+	.dma_slave_rx	= SHDMA_SLAVE_SDHI1_RX,
+	.set_pwr	= sdhi1_set_pwr,
 };
 
 static struct resource sdhi1_resources[] = {
@@ -546,6 +551,8 @@ static struct spi_board_info spi_bus[] = {
 /* MSIOF0 */
 static struct sh_msiof_spi_info msiof0_data = {
 	.num_chipselect = 1,
+	.dma_slave_tx	= SHDMA_SLAVE_MSIOF0_TX,
+	.dma_slave_rx	= SHDMA_SLAVE_MSIOF0_RX,
 };
 
 static struct resource msiof0_resources[] = {
@@ -723,6 +730,8 @@ struct sh_fsi_platform_info fsi_info = {
 		       SH_FSI_IN_SLAVE_MODE |
 		       SH_FSI_OFMT(I2S) |
 		       SH_FSI_IFMT(I2S),
+	.portb_dma_slave_tx = SHDMA_SLAVE_FSIB_TX,
+	.portb_dma_slave_rx = SHDMA_SLAVE_FSIB_RX,
 };
 
 static struct resource fsi_resources[] = {
@@ -90,6 +90,25 @@ void kunmap_coherent(void *kvaddr);
 
 #define PG_dcache_dirty	PG_arch_1
 
+/*
+ * D-cache alias flush accounting, see cache-debugfs.c.
+ */
+enum {
+	DCACHE_STAT_FLUSH_EAGER,
+	DCACHE_STAT_FLUSH_DEFERRED,
+	DCACHE_STAT_FLUSH_LAZY,
+	DCACHE_STAT_FLUSH_AVOIDED,
+
+	NR_DCACHE_STATS,
+};
+
+#if defined(CONFIG_CPU_SH4) && defined(CONFIG_DEBUG_FS)
+extern unsigned long dcache_stats[NR_CPUS][NR_DCACHE_STATS];
+#define dcache_stat_inc(cpu, item)	(dcache_stats[cpu][item]++)
+#else
+#define dcache_stat_inc(cpu, item)	do { } while (0)
+#endif
+
 void cpu_cache_init(void);
 
 #endif /* __KERNEL__ */
@@ -21,6 +21,7 @@ struct clk_ops {
 
 struct clk {
 	struct list_head	node;
+	struct hlist_node	hash_node;	/* clk_get() by name */
 	const char		*name;
 	int			id;
 	struct module		*owner;
@@ -32,6 +33,7 @@ struct clk {
 	struct list_head	sibling;	/* node for children */
 
 	int			usecount;
+	u32			toggles;	/* off -> on transitions */
 
 	unsigned long		rate;
 	unsigned long		flags;
@@ -46,7 +48,7 @@ struct clk {
 };
 
 struct clk_lookup {
-	struct list_head	node;
+	struct hlist_node	node;
 	const char		*dev_id;
 	const char		*con_id;
 	struct clk		*clk;
@@ -66,6 +68,8 @@ void propagate_rate(struct clk *);
 int clk_reparent(struct clk *child, struct clk *parent);
 int clk_register(struct clk *);
 void clk_unregister(struct clk *);
+void clkdev_add(struct clk_lookup *cl);
+void clkdev_drop(struct clk_lookup *cl);
 
 /* arch/sh/kernel/cpu/clock-cpg.c */
 int __init __deprecated cpg_clk_init(void);
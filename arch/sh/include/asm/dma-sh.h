@@ -11,6 +11,7 @@
 #ifndef __DMA_SH_H
 #define __DMA_SH_H
 
+#include <linux/dmaengine.h>
 #include <asm/dma.h>
 #include <cpu/dma.h>
 
@@ -118,6 +119,16 @@ static u32 dma_base_addr[] __maybe_unused = {
 #define CHCR    0x0C
 #define DMAOR	0x40
 
+/*
+ * Reload function: when TCR runs out, SARB/DARB/TCRB are copied into
+ * SAR/DAR/TCR and the channel carries on with the next block.
+ */
+#define SARB	0x100
+#define DARB	0x104
+#define TCRB	0x108
+#define CHCR_RPT_MASK	0x0e000000
+#define CHCR_RPT_RELOAD	0x0a000000	/* SAR/DAR/TCR reload mode */
+
 /*
  * for dma engine
  *
@@ -126,8 +137,10 @@ static u32 dma_base_addr[] __maybe_unused = {
 #define SHDMA_MIX_IRQ	(1 << 1)
 #define SHDMA_DMAOR1	(1 << 2)
 #define SHDMA_DMAE1	(1 << 3)
+#define SHDMA_RELOAD	(1 << 4)	/* channels 0-3 of each DMAC reload */
 
 enum sh_dmae_slave_chan_id {
+	SHDMA_SLAVE_INVALID,	/* No DMA slave assigned */
 	SHDMA_SLAVE_SCIF0_TX,
 	SHDMA_SLAVE_SCIF0_RX,
 	SHDMA_SLAVE_SCIF1_TX,
@@ -144,6 +157,20 @@ enum sh_dmae_slave_chan_id {
 	SHDMA_SLAVE_SIUA_RX,
 	SHDMA_SLAVE_SIUB_TX,
 	SHDMA_SLAVE_SIUB_RX,
+	SHDMA_SLAVE_SDHI0_TX,
+	SHDMA_SLAVE_SDHI0_RX,
+	SHDMA_SLAVE_SDHI1_TX,
+	SHDMA_SLAVE_SDHI1_RX,
+	SHDMA_SLAVE_MSIOF0_TX,
+	SHDMA_SLAVE_MSIOF0_RX,
+	SHDMA_SLAVE_MSIOF1_TX,
+	SHDMA_SLAVE_MSIOF1_RX,
+	SHDMA_SLAVE_FLCTL0_TX,
+	SHDMA_SLAVE_FLCTL0_RX,
+	SHDMA_SLAVE_FSIA_TX,
+	SHDMA_SLAVE_FSIA_RX,
+	SHDMA_SLAVE_FSIB_TX,
+	SHDMA_SLAVE_FSIB_RX,
 	SHDMA_SLAVE_NUMBER,	/* Must stay last */
 };
 
@@ -168,4 +195,10 @@ struct sh_dmae_slave {
 	struct sh_dmae_slave_config	*config;  /* Set by the driver */
 };
 
+/* Every period of a cyclic transfer takes a descriptor of its own */
+#define SH_DMAE_CYCLIC_PERIODS_MAX	32
+
+dma_addr_t sh_dmae_get_position(struct dma_chan *chan);
+size_t sh_dmae_get_partial(struct dma_async_tx_descriptor *tx);
+
 #endif /* __DMA_SH_H */
@@ -20,6 +20,8 @@ extern void save_fpu(struct task_struct *__tsk);
 extern void restore_fpu(struct task_struct *__tsk);
 extern void fpu_state_restore(struct pt_regs *regs);
 extern void __fpu_state_restore(void);
+extern void kernel_fpu_begin(void);
+extern void kernel_fpu_end(void);
 #else
 #define save_fpu(tsk)			do { } while (0)
 #define restore_fpu(tsk)		do { } while (0)
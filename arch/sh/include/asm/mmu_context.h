@@ -12,7 +12,23 @@
 #include <asm/tlbflush.h>
 #include <asm/uaccess.h>
 #include <asm/io.h>
+
+#if defined(CONFIG_MMU) && defined(CONFIG_CPU_SH4)
+/* Wired UTLB slots of the dying mm, see arch/sh/mm/tlb-urb.c */
+extern void tlb_wired_exit_mmap(struct mm_struct *mm);
+
+static inline void arch_dup_mmap(struct mm_struct *oldmm,
+				 struct mm_struct *mm)
+{
+}
+
+static inline void arch_exit_mmap(struct mm_struct *mm)
+{
+	tlb_wired_exit_mmap(mm);
+}
+#else
 #include <asm-generic/mm_hooks.h>
+#endif
 
 /*
  * The MMU "context" consists of two things:
@@ -69,6 +85,7 @@ static inline void get_mmu_context(struct mm_struct *mm, unsigned int cpu)
 		 * We exhaust ASID of this version.
 		 * Flush all TLB and start new cycle.
 		 */
+		tlb_stat_inc(cpu, TLB_STAT_ASID_ROLLOVER);
 		local_flush_tlb_all();
 
 #ifdef CONFIG_SUPERH64
@@ -87,6 +104,7 @@ static inline void get_mmu_context(struct mm_struct *mm, unsigned int cpu)
 			asid = MMU_CONTEXT_FIRST_VERSION;
 	}
 
+	tlb_stat_inc(cpu, TLB_STAT_ASID_ALLOC);
 	cpu_context(cpu, mm) = asid_cache(cpu) = asid;
 }
 
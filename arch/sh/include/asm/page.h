@@ -57,7 +57,16 @@ pages_do_alias(unsigned long addr1, unsigned long addr2)
 	return (addr1 ^ addr2) & shm_align_mask;
 }
 
+#if defined(CONFIG_CPU_SH4A) && defined(CONFIG_MMU)
+extern void clear_page(void *to);
+extern void __clear_page_sh4a(void *to);
+extern void __clear_page_sh4a_fpu(void *to);
+extern void __copy_page_sh4a(void *to, void *from);
+extern void __copy_page_sh4a_fpu(void *to, void *from);
+extern void __copy_page_generic(void *to, void *from);
+#else
 #define clear_page(page)	memset((void *)(page), 0, PAGE_SIZE)
+#endif
 extern void copy_page(void *to, void *from);
 
 struct page;
@@ -8,6 +8,7 @@ struct hw_perf_event;
 struct sh_pmu {
 	const char	*name;
 	unsigned int	num_events;
+	unsigned int	counter_width;
 	void		(*disable_all)(void);
 	void		(*enable_all)(void);
 	void		(*enable)(struct hw_perf_event *, int);
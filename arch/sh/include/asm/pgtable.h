@@ -152,6 +152,15 @@ extern void __update_cache(struct vm_area_struct *vma,
 extern void __update_tlb(struct vm_area_struct *vma,
 			 unsigned long address, pte_t pte);
 
+#ifdef CONFIG_TLB_LARGE_PAGES
+extern pte_t tlb_large_pte(unsigned long *address, pte_t pte);
+#else
+static inline pte_t tlb_large_pte(unsigned long *address, pte_t pte)
+{
+	return pte;
+}
+#endif
+
 static inline void
 update_mmu_cache(struct vm_area_struct *vma, unsigned long address, pte_t pte)
 {
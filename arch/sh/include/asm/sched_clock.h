@@ -0,0 +1,19 @@
+#ifndef __ASM_SH_SCHED_CLOCK_H
+#define __ASM_SH_SCHED_CLOCK_H
+
+/*
+ * Timer drivers with a free-running counter of up to 32 bits that can be
+ * read without taking any locks hand it to sched_clock() while it runs.
+ * Until then, and whenever it is stopped again, sched_clock() counts
+ * jiffies.
+ *
+ * The counter is registered at probe time, and started and stopped from
+ * the clocksource ->enable() and ->disable() methods.
+ */
+struct clocksource;
+
+void sh_sched_clock_register(struct clocksource *cs, unsigned long rate);
+void sh_sched_clock_start(struct clocksource *cs);
+void sh_sched_clock_stop(struct clocksource *cs);
+
+#endif /* __ASM_SH_SCHED_CLOCK_H */
@@ -114,6 +114,34 @@ static inline void tlb_unwire_entry(void)
 }
 #endif
 
+#ifdef CONFIG_CPU_SH4
+extern void tlb_load_entry(unsigned long address, pte_t pte);
+
+/*
+ * Wired UTLB entries for hot mappings, see arch/sh/mm/tlb-urb.c.
+ * A NULL mm refers to kernel mappings.
+ */
+extern int tlb_wire_range(struct mm_struct *mm, unsigned long start,
+			  unsigned long size);
+extern void tlb_unwire_range(struct mm_struct *mm, unsigned long start,
+			     unsigned long size);
+
+extern unsigned int tlb_nr_wired;
+extern int __tlb_wired_update(unsigned long address, pte_t pte);
+
+/*
+ * Called from __update_tlb(); loads the entry into its wired slot and
+ * returns 1 if @address is wired, returns 0 otherwise.
+ */
+static inline int tlb_wired_update(unsigned long address, pte_t pte)
+{
+	if (likely(!tlb_nr_wired))
+		return 0;
+
+	return __tlb_wired_update(address, pte);
+}
+#endif
+
 #else /* CONFIG_MMU */
 
 #define tlb_start_vma(tlb, vma)				do { } while (0)
@@ -1,6 +1,8 @@
 #ifndef __ASM_SH_TLBFLUSH_H
 #define __ASM_SH_TLBFLUSH_H
 
+#include <linux/threads.h>
+
 /*
  * TLB flushing:
  *
@@ -20,6 +22,45 @@ extern void local_flush_tlb_page(struct vm_area_struct *vma,
 extern void local_flush_tlb_kernel_range(unsigned long start,
 					 unsigned long end);
 extern void local_flush_tlb_one(unsigned long asid, unsigned long page);
+extern void local_flush_tlb_pages(unsigned long asid, unsigned long start,
+				  unsigned long end);
+extern void local_flush_tlb_scan(unsigned long asid, unsigned long start,
+				 unsigned long end);
+
+/*
+ * Event counters, exported through debugfs.
+ */
+enum {
+	TLB_STAT_ASID_ALLOC,
+	TLB_STAT_ASID_ROLLOVER,
+	TLB_STAT_FLUSH_ALL,
+	TLB_STAT_FLUSH_MM,
+	TLB_STAT_FLUSH_PAGE,
+	TLB_STAT_FLUSH_RANGE,
+	TLB_STAT_FLUSH_RANGE_PAGES,
+	TLB_STAT_FLUSH_RANGE_CONTEXT,
+	TLB_STAT_FLUSH_KERNEL_RANGE,
+	TLB_STAT_FLUSH_KERNEL_RANGE_ALL,
+	TLB_STAT_LOAD_64K,
+	TLB_STAT_LOAD_1M,
+	TLB_STAT_LOAD_WIRED,
+	TLB_STAT_REFILL_FAST,
+	TLB_STAT_REFILL_SLOW,
+
+	NR_TLB_STATS,
+};
+
+#ifdef CONFIG_DEBUG_FS
+extern unsigned long tlb_stats[NR_CPUS][NR_TLB_STATS];
+#define tlb_stat_add(cpu, item, n)	(tlb_stats[cpu][item] += (n))
+#else
+#define tlb_stat_add(cpu, item, n)	do { } while (0)
+#endif
+#define tlb_stat_inc(cpu, item)		tlb_stat_add(cpu, item, 1)
+
+#ifdef CONFIG_TLB_FAST_REFILL
+extern u32 tlb_fast_refill;
+#endif
 
 #ifdef CONFIG_SMP
 
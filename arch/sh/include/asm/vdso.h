@@ -0,0 +1,40 @@
+#ifndef __ASM_SH_VDSO_H
+#define __ASM_SH_VDSO_H
+
+#include <linux/types.h>
+
+/*
+ * Timekeeping state shared with the vDSO. The kernel keeps it in the page
+ * following the vDSO text, and maps the clocksource counter read-only and
+ * uncached in the page after that. @seq is odd while an update is going on.
+ */
+struct vdso_data {
+	u32 seq;
+	u32 counter_valid;	/* 0 if the vDSO has to take the syscall */
+	u32 counter_offset;	/* of the counter in its page */
+	u32 counter_xor;	/* ~0 turns a down counter into an up counter */
+	u32 cycle_last;
+	u32 mask;
+	u32 mult;
+	u32 shift;
+	u32 wall_time_sec;
+	u32 wall_time_nsec;
+	s32 wall_to_mono_sec;
+	u32 wall_to_mono_nsec;
+	s32 tz_minuteswest;
+	s32 tz_dsttime;
+};
+
+struct clocksource;
+
+#ifdef CONFIG_GENERIC_TIME_VSYSCALL
+void vdso_register_counter(struct clocksource *cs, unsigned long addr,
+			   u32 xor);
+#else
+static inline void vdso_register_counter(struct clocksource *cs,
+					 unsigned long addr, u32 xor)
+{
+}
+#endif
+
+#endif /* __ASM_SH_VDSO_H */
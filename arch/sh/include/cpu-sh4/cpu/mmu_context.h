@@ -19,9 +19,12 @@
 
 #define MMUCR		0xFF000010	/* MMU Control Register */
 
+#define MMU_ITLB_ADDRESS_ARRAY	0xF2000000
 #define MMU_UTLB_ADDRESS_ARRAY	0xF6000000
 #define MMU_UTLB_ADDRESS_ARRAY2	0xF6800000
 #define MMU_PAGE_ASSOC_BIT	0x80
+#define MMU_TLB_ENTRY_SHIFT	8	/* entry select in the array address */
+#define MMU_TLB_VALID		0x100	/* V bit in an address array entry */
 
 #define MMUCR_TI		(1<<2)
 
@@ -29,6 +32,9 @@
 #define MMUCR_URB_SHIFT		18
 #define MMUCR_URB_NENTRIES	64
 
+#define MMUCR_URC		0x0000FC00
+#define MMUCR_URC_SHIFT		10
+
 #if defined(CONFIG_32BIT) && defined(CONFIG_CPU_SUBTYPE_ST40)
 #define MMUCR_SE		(1 << 4)
 #else
@@ -54,6 +60,7 @@
 #endif
 
 #define MMU_NTLB_ENTRIES	64
+#define MMU_NITLB_ENTRIES	4
 #define MMU_CONTROL_INIT	(0x05|MMUCR_SQMD|MMUCR_ME|MMUCR_SE|MMUCR_AEX)
 
 #define TRA	0xff000020
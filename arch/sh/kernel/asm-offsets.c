@@ -16,6 +16,7 @@
 
 #include <asm/thread_info.h>
 #include <asm/suspend.h>
+#include <asm/tlbflush.h>
 
 int main(void)
 {
@@ -57,5 +58,10 @@ int main(void)
 	DEFINE(SH_SLEEP_REG_IRMCR, offsetof(struct sh_sleep_regs, irmcr));
 	DEFINE(SH_SLEEP_REG_CCR, offsetof(struct sh_sleep_regs, ccr));
 	DEFINE(SH_SLEEP_REG_RAMCR, offsetof(struct sh_sleep_regs, ramcr));
+
+#if defined(CONFIG_TLB_FAST_REFILL) && defined(CONFIG_DEBUG_FS)
+	DEFINE(TLB_STAT_REFILL_FAST_OFFSET,
+	       TLB_STAT_REFILL_FAST * sizeof(unsigned long));
+#endif
 	return 0;
 }
@@ -30,6 +30,8 @@
 #include <linux/platform_device.h>
 #include <linux/debugfs.h>
 #include <linux/cpufreq.h>
+#include <linux/jhash.h>
+#include <linux/jiffies.h>
 #include <asm/clock.h>
 #include <asm/machvec.h>
 
@@ -37,6 +39,22 @@ static LIST_HEAD(clock_list);
 static DEFINE_SPINLOCK(clock_lock);
 static DEFINE_MUTEX(clock_list_sem);
 
+/*
+ * Clocks are hashed by name and clk_lookups by dev_id, or by con_id for
+ * those without one, so neither clk_get() nor clk_get_sys() has to walk
+ * everything that is registered. Both are covered by clock_list_sem.
+ */
+#define CLK_HASH_BITS	6
+#define CLK_HASH_SIZE	(1 << CLK_HASH_BITS)
+
+static struct hlist_head clock_hash[CLK_HASH_SIZE];
+static struct hlist_head clk_lookup_hash[CLK_HASH_SIZE];
+
+static inline unsigned int clk_hashfn(const char *name)
+{
+	return jhash(name, strlen(name), 0) & (CLK_HASH_SIZE - 1);
+}
+
 void clk_rate_table_build(struct clk *clk,
 			  struct cpufreq_frequency_table *freq_table,
 			  int nr_freqs,
@@ -162,21 +180,60 @@ void propagate_rate(struct clk *tclk)
 	}
 }
 
+/*
+ * Only the transitions between unused and used touch the hardware and
+ * the parent, and they are made under clock_lock. Any other change of
+ * usecount is a plain atomic update, so nested users and drivers that
+ * keep a clock on across runtime PM cycles never take the lock.
+ */
+static inline int clk_usecount_inc_not_zero(struct clk *clk)
+{
+	int old;
+
+	do {
+		old = ACCESS_ONCE(clk->usecount);
+		if (old == 0)
+			return 0;
+	} while (cmpxchg(&clk->usecount, old, old + 1) != old);
+
+	return 1;
+}
+
+static inline int clk_usecount_dec_not_one(struct clk *clk)
+{
+	int old;
+
+	do {
+		old = ACCESS_ONCE(clk->usecount);
+		if (old <= 1)
+			return 0;
+	} while (cmpxchg(&clk->usecount, old, old - 1) != old);
+
+	return 1;
+}
+
 static void __clk_disable(struct clk *clk)
 {
-	if (clk->usecount == 0) {
-		printk(KERN_ERR "Trying disable clock %s with 0 usecount\n",
-		       clk->name);
-		WARN_ON(1);
+	if (clk_usecount_dec_not_one(clk))
 		return;
-	}
 
-	if (!(--clk->usecount)) {
-		if (likely(clk->ops && clk->ops->disable))
-			clk->ops->disable(clk);
-		if (likely(clk->parent))
-			__clk_disable(clk->parent);
+	/* a lockless clk_enable() may still move us from 1 to 2 */
+	if (cmpxchg(&clk->usecount, 1, 0) != 1) {
+		if (clk->usecount == 0) {
+			printk(KERN_ERR "Trying disable clock %s with 0 "
+			       "usecount\n", clk->name);
+			WARN_ON(1);
+			return;
+		}
+
+		__clk_disable(clk);
+		return;
 	}
+
+	if (likely(clk->ops && clk->ops->disable))
+		clk->ops->disable(clk);
+	if (likely(clk->parent))
+		__clk_disable(clk->parent);
 }
 
 void clk_disable(struct clk *clk)
@@ -186,6 +243,9 @@ void clk_disable(struct clk *clk)
 	if (!clk)
 		return;
 
+	if (clk_usecount_dec_not_one(clk))
+		return;
+
 	spin_lock_irqsave(&clock_lock, flags);
 	__clk_disable(clk);
 	spin_unlock_irqrestore(&clock_lock, flags);
@@ -194,29 +254,34 @@ EXPORT_SYMBOL_GPL(clk_disable);
 
 static int __clk_enable(struct clk *clk)
 {
-	int ret = 0;
+	int ret;
 
-	if (clk->usecount++ == 0) {
-		if (clk->parent) {
-			ret = __clk_enable(clk->parent);
-			if (unlikely(ret))
-				goto err;
-		}
+	if (clk_usecount_inc_not_zero(clk))
+		return 0;
 
-		if (clk->ops && clk->ops->enable) {
-			ret = clk->ops->enable(clk);
-			if (ret) {
-				if (clk->parent)
-					__clk_disable(clk->parent);
-				goto err;
-			}
+	/* usecount can only leave zero under clock_lock, which we hold */
+	if (clk->parent) {
+		ret = __clk_enable(clk->parent);
+		if (unlikely(ret))
+			return ret;
+	}
+
+	if (clk->ops && clk->ops->enable) {
+		ret = clk->ops->enable(clk);
+		if (ret) {
+			if (clk->parent)
+				__clk_disable(clk->parent);
+			return ret;
 		}
 	}
 
-	return ret;
-err:
-	clk->usecount--;
-	return ret;
+	clk->toggles++;
+
+	/* the clock must be running before the lockless path can see it */
+	smp_wmb();
+	clk->usecount = 1;
+
+	return 0;
 }
 
 int clk_enable(struct clk *clk)
@@ -227,6 +292,9 @@ int clk_enable(struct clk *clk)
 	if (!clk)
 		return -EINVAL;
 
+	if (clk_usecount_inc_not_zero(clk))
+		return 0;
+
 	spin_lock_irqsave(&clock_lock, flags);
 	ret = __clk_enable(clk);
 	spin_unlock_irqrestore(&clock_lock, flags);
@@ -277,6 +345,7 @@ int clk_register(struct clk *clk)
 		list_add(&clk->sibling, &root_clks);
 
 	list_add(&clk->node, &clock_list);
+	hlist_add_head(&clk->hash_node, &clock_hash[clk_hashfn(clk->name)]);
 	if (clk->ops && clk->ops->init)
 		clk->ops->init(clk);
 	mutex_unlock(&clock_list_sem);
@@ -290,10 +359,36 @@ void clk_unregister(struct clk *clk)
 	mutex_lock(&clock_list_sem);
 	list_del(&clk->sibling);
 	list_del(&clk->node);
+	hlist_del(&clk->hash_node);
 	mutex_unlock(&clock_list_sem);
 }
 EXPORT_SYMBOL_GPL(clk_unregister);
 
+static inline const char *clk_lookup_key(struct clk_lookup *cl)
+{
+	return cl->dev_id ? cl->dev_id : cl->con_id;
+}
+
+void clkdev_add(struct clk_lookup *cl)
+{
+	if (WARN_ON(!clk_lookup_key(cl)))
+		return;
+
+	mutex_lock(&clock_list_sem);
+	hlist_add_head(&cl->node,
+		       &clk_lookup_hash[clk_hashfn(clk_lookup_key(cl))]);
+	mutex_unlock(&clock_list_sem);
+}
+EXPORT_SYMBOL_GPL(clkdev_add);
+
+void clkdev_drop(struct clk_lookup *cl)
+{
+	mutex_lock(&clock_list_sem);
+	hlist_del(&cl->node);
+	mutex_unlock(&clock_list_sem);
+}
+EXPORT_SYMBOL_GPL(clkdev_drop);
+
 static void clk_enable_init_clocks(void)
 {
 	struct clk *clkp;
@@ -409,29 +504,42 @@ EXPORT_SYMBOL_GPL(clk_round_rate);
 static struct clk *clk_find(const char *dev_id, const char *con_id)
 {
 	struct clk_lookup *p;
+	struct hlist_node *n;
 	struct clk *clk = NULL;
 	int match, best = 0;
 
-	list_for_each_entry(p, &clock_list, node) {
-		match = 0;
-		if (p->dev_id) {
-			if (!dev_id || strcmp(p->dev_id, dev_id))
+	/* dev+con and dev only entries all live in the dev_id bucket */
+	if (dev_id) {
+		hlist_for_each_entry(p, n, &clk_lookup_hash[clk_hashfn(dev_id)],
+				     node) {
+			if (!p->dev_id || strcmp(p->dev_id, dev_id))
 				continue;
-			match += 2;
-		}
-		if (p->con_id) {
-			if (!con_id || strcmp(p->con_id, con_id))
-				continue;
-			match += 1;
+			match = 2;
+			if (p->con_id) {
+				if (!con_id || strcmp(p->con_id, con_id))
+					continue;
+				match += 1;
+			}
+
+			if (match > best) {
+				clk = p->clk;
+				best = match;
+			}
 		}
-		if (match == 0)
-			continue;
 
-		if (match > best) {
-			clk = p->clk;
-			best = match;
+		if (best)
+			return clk;
+	}
+
+	/* con only entries are hashed by con_id */
+	if (con_id) {
+		hlist_for_each_entry(p, n, &clk_lookup_hash[clk_hashfn(con_id)],
+				     node) {
+			if (!p->dev_id && p->con_id && !strcmp(p->con_id, con_id))
+				return p->clk;
 		}
 	}
+
 	return clk;
 }
 
@@ -455,6 +563,8 @@ struct clk *clk_get(struct device *dev, const char *id)
 {
 	const char *dev_id = dev ? dev_name(dev) : NULL;
 	struct clk *p, *clk = ERR_PTR(-ENOENT);
+	struct hlist_head *head;
+	struct hlist_node *n;
 	int idno;
 
 	clk = clk_get_sys(dev_id, id);
@@ -466,8 +576,10 @@ struct clk *clk_get(struct device *dev, const char *id)
 	else
 		idno = to_platform_device(dev)->id;
 
+	head = &clock_hash[clk_hashfn(id)];
+
 	mutex_lock(&clock_list_sem);
-	list_for_each_entry(p, &clock_list, node) {
+	hlist_for_each_entry(p, n, head, hash_node) {
 		if (p->id == idno &&
 		    strcmp(id, p->name) == 0 && try_module_get(p->owner)) {
 			clk = p;
@@ -475,7 +587,7 @@ struct clk *clk_get(struct device *dev, const char *id)
 		}
 	}
 
-	list_for_each_entry(p, &clock_list, node) {
+	hlist_for_each_entry(p, n, head, hash_node) {
 		if (strcmp(id, p->name) == 0 && try_module_get(p->owner)) {
 			clk = p;
 			break;
@@ -626,6 +738,11 @@ static int clk_debugfs_register_one(struct clk *c)
 		err = -ENOMEM;
 		goto err_out;
 	}
+	d = debugfs_create_u32("toggles", S_IRUGO, c->dentry, &c->toggles);
+	if (!d) {
+		err = -ENOMEM;
+		goto err_out;
+	}
 	return 0;
 
 err_out:
@@ -655,6 +772,84 @@ static int clk_debugfs_register(struct clk *c)
 	return 0;
 }
 
+/*
+ * clock/summary: the whole tree with use counts, rates and how often
+ * each clock was switched on since the counts were last cleared, which
+ * is what a write to the file does. Drivers that thrash their clocks
+ * through runtime PM stand out by their toggles per second.
+ */
+static unsigned long clk_toggles_stamp = INITIAL_JIFFIES;
+
+static void clk_summary_show_one(struct seq_file *file, struct clk *c,
+				 int level, unsigned long secs)
+{
+	struct clk *child;
+	char name[32];
+
+	if (c->id >= 0)
+		snprintf(name, sizeof(name), "%s:%d", c->name, c->id);
+	else
+		strlcpy(name, c->name, sizeof(name));
+
+	seq_printf(file, "%*s%-*s %5d %11lu %9u %7lu\n", level * 2, "",
+		   30 - level * 2, name, c->usecount, c->rate, c->toggles,
+		   c->toggles / secs);
+
+	list_for_each_entry(child, &c->children, sibling)
+		clk_summary_show_one(file, child, level + 1, secs);
+}
+
+static int clk_summary_show(struct seq_file *file, void *iter)
+{
+	unsigned long secs, flags;
+	struct clk *c;
+
+	secs = (jiffies - clk_toggles_stamp) / HZ;
+	if (!secs)
+		secs = 1;
+
+	seq_printf(file, "%-30s %5s %11s %9s %7s\n", "clock", "use",
+		   "rate", "toggles", "per sec");
+
+	spin_lock_irqsave(&clock_lock, flags);
+	list_for_each_entry(c, &root_clks, sibling)
+		clk_summary_show_one(file, c, 0, secs);
+	spin_unlock_irqrestore(&clock_lock, flags);
+
+	return 0;
+}
+
+static int clk_summary_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, clk_summary_show, inode->i_private);
+}
+
+static ssize_t clk_summary_write(struct file *file, const char __user *buf,
+				 size_t count, loff_t *ppos)
+{
+	unsigned long flags;
+	struct clk *c;
+
+	mutex_lock(&clock_list_sem);
+	spin_lock_irqsave(&clock_lock, flags);
+	list_for_each_entry(c, &clock_list, node)
+		c->toggles = 0;
+	clk_toggles_stamp = jiffies;
+	spin_unlock_irqrestore(&clock_lock, flags);
+	mutex_unlock(&clock_list_sem);
+
+	return count;
+}
+
+static const struct file_operations clk_summary_fops = {
+	.owner		= THIS_MODULE,
+	.open		= clk_summary_open,
+	.read		= seq_read,
+	.write		= clk_summary_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 static int __init clk_debugfs_init(void)
 {
 	struct clk *c;
@@ -666,6 +861,13 @@ static int __init clk_debugfs_init(void)
 		return -ENOMEM;
 	clk_debugfs_root = d;
 
+	d = debugfs_create_file("summary", S_IRUSR | S_IWUSR,
+				clk_debugfs_root, NULL, &clk_summary_fops);
+	if (!d) {
+		err = -ENOMEM;
+		goto err_out;
+	}
+
 	list_for_each_entry(c, &clock_list, node) {
 		err = clk_debugfs_register(c);
 		if (err)
@@ -1,4 +1,5 @@
 #include <linux/sched.h>
+#include <linux/module.h>
 #include <asm/processor.h>
 #include <asm/fpu.h>
 
@@ -75,6 +76,27 @@ void fpu_state_restore(struct pt_regs *regs)
 	__fpu_state_restore();
 }
 
+/*
+ * Borrow the FPU for kernel code. Any live user state is saved and
+ * handed back lazily through the usual FPU disable trap. Not for use
+ * from interrupt context, and nothing in between may sleep or touch
+ * the FPU through another kernel_fpu_begin().
+ */
+void kernel_fpu_begin(void)
+{
+	preempt_disable();
+	__unlazy_fpu(current, task_pt_regs(current));
+	enable_fpu();
+}
+EXPORT_SYMBOL(kernel_fpu_begin);
+
+void kernel_fpu_end(void)
+{
+	disable_fpu();
+	preempt_enable();
+}
+EXPORT_SYMBOL(kernel_fpu_end);
+
 BUILD_TRAP_HANDLER(fpu_state_restore)
 {
 	TRAP_HANDLER_DECL;
@@ -227,6 +227,7 @@ static void sh7750_pmu_enable_all(void)
 static struct sh_pmu sh7750_pmu = {
 	.name		= "SH7750",
 	.num_events	= 2,
+	.counter_width	= 48,
 	.event_map	= sh7750_event_map,
 	.max_events	= ARRAY_SIZE(sh7750_general_events),
 	.raw_event_mask	= PMCR_PMM_MASK,
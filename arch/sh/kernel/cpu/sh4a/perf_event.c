@@ -145,8 +145,8 @@ static const int sh4a_cache_events
 
 	[ C(DTLB) ] = {
 		[ C(OP_READ) ] = {
-			[ C(RESULT_ACCESS) ] = 0x0222,
-			[ C(RESULT_MISS)   ] = 0x0220,
+			[ C(RESULT_ACCESS) ] = 0,
+			[ C(RESULT_MISS)   ] = 0x0222,
 		},
 		[ C(OP_WRITE) ] = {
 			[ C(RESULT_ACCESS) ] = 0,
@@ -243,6 +243,7 @@ static void sh4a_pmu_enable_all(void)
 static struct sh_pmu sh4a_pmu = {
 	.name		= "SH-4A",
 	.num_events	= 2,
+	.counter_width	= 32,
 	.event_map	= sh4a_event_map,
 	.max_events	= ARRAY_SIZE(sh4a_general_events),
 	.raw_event_mask	= 0x3ff,
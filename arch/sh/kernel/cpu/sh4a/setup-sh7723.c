@@ -17,9 +17,41 @@
 #include <linux/sh_timer.h>
 #include <linux/io.h>
 #include <asm/clock.h>
+#include <asm/dma-sh.h>
 #include <asm/mmzone.h>
 #include <cpu/sh7723.h>
 
+/* DMA */
+static struct sh_dmae_slave_config sh7723_dmae_slaves[] = {
+	{
+		.slave_id	= SHDMA_SLAVE_FLCTL0_TX,
+		.addr		= 0xa4530050,
+		.chcr		= DM_FIX | SM_INC | 0x800 |
+				  TS_INDEX2VAL(XMIT_SZ_32BIT),
+		.mid_rid	= 0x83,
+	}, {
+		.slave_id	= SHDMA_SLAVE_FLCTL0_RX,
+		.addr		= 0xa4530050,
+		.chcr		= DM_INC | SM_FIX | 0x800 |
+				  TS_INDEX2VAL(XMIT_SZ_32BIT),
+		.mid_rid	= 0x83,
+	},
+};
+
+static struct sh_dmae_pdata dma_platform_data = {
+	.mode		= SHDMA_DMAOR1,
+	.config		= sh7723_dmae_slaves,
+	.config_num	= ARRAY_SIZE(sh7723_dmae_slaves),
+};
+
+static struct platform_device dma_device = {
+	.name	= "sh-dma-engine",
+	.id		= -1,
+	.dev	= {
+		.platform_data	= &dma_platform_data,
+	},
+};
+
 /* Serial */
 static struct plat_sci_port scif0_platform_data = {
 	.mapbase        = 0xffe00000,
@@ -548,6 +580,7 @@ static struct platform_device *sh7723_devices[] __initdata = {
 	&tmu3_device,
 	&tmu4_device,
 	&tmu5_device,
+	&dma_device,
 	&rtc_device,
 	&iic_device,
 	&sh7723_usb_host_device,
@@ -28,8 +28,158 @@
 #include <cpu/sh7724.h>
 
 /* DMA */
+static struct sh_dmae_slave_config sh7724_dmae_slaves[] = {
+	{
+		.slave_id	= SHDMA_SLAVE_SCIF0_TX,
+		.addr		= 0xffe0000c,
+		.chcr		= DM_FIX | SM_INC | 0x800 |
+				  TS_INDEX2VAL(XMIT_SZ_8BIT),
+		.mid_rid	= 0x21,
+	}, {
+		.slave_id	= SHDMA_SLAVE_SCIF0_RX,
+		.addr		= 0xffe00014,
+		.chcr		= DM_INC | SM_FIX | 0x800 |
+				  TS_INDEX2VAL(XMIT_SZ_8BIT),
+		.mid_rid	= 0x22,
+	}, {
+		.slave_id	= SHDMA_SLAVE_SCIF1_TX,
+		.addr		= 0xffe1000c,
+		.chcr		= DM_FIX | SM_INC | 0x800 |
+				  TS_INDEX2VAL(XMIT_SZ_8BIT),
+		.mid_rid	= 0x25,
+	}, {
+		.slave_id	= SHDMA_SLAVE_SCIF1_RX,
+		.addr		= 0xffe10014,
+		.chcr		= DM_INC | SM_FIX | 0x800 |
+				  TS_INDEX2VAL(XMIT_SZ_8BIT),
+		.mid_rid	= 0x26,
+	}, {
+		.slave_id	= SHDMA_SLAVE_SCIF2_TX,
+		.addr		= 0xffe2000c,
+		.chcr		= DM_FIX | SM_INC | 0x800 |
+				  TS_INDEX2VAL(XMIT_SZ_8BIT),
+		.mid_rid	= 0x29,
+	}, {
+		.slave_id	= SHDMA_SLAVE_SCIF2_RX,
+		.addr		= 0xffe20014,
+		.chcr		= DM_INC | SM_FIX | 0x800 |
+				  TS_INDEX2VAL(XMIT_SZ_8BIT),
+		.mid_rid	= 0x2a,
+	}, {
+		.slave_id	= SHDMA_SLAVE_SCIF3_TX,
+		.addr		= 0xa4e30020,
+		.chcr		= DM_FIX | SM_INC | 0x800 |
+				  TS_INDEX2VAL(XMIT_SZ_8BIT),
+		.mid_rid	= 0x2d,
+	}, {
+		.slave_id	= SHDMA_SLAVE_SCIF3_RX,
+		.addr		= 0xa4e30024,
+		.chcr		= DM_INC | SM_FIX | 0x800 |
+				  TS_INDEX2VAL(XMIT_SZ_8BIT),
+		.mid_rid	= 0x2e,
+	}, {
+		.slave_id	= SHDMA_SLAVE_SCIF4_TX,
+		.addr		= 0xa4e40020,
+		.chcr		= DM_FIX | SM_INC | 0x800 |
+				  TS_INDEX2VAL(XMIT_SZ_8BIT),
+		.mid_rid	= 0x31,
+	}, {
+		.slave_id	= SHDMA_SLAVE_SCIF4_RX,
+		.addr		= 0xa4e40024,
+		.chcr		= DM_INC | SM_FIX | 0x800 |
+				  TS_INDEX2VAL(XMIT_SZ_8BIT),
+		.mid_rid	= 0x32,
+	}, {
+		.slave_id	= SHDMA_SLAVE_SCIF5_TX,
+		.addr		= 0xa4e50020,
+		.chcr		= DM_FIX | SM_INC | 0x800 |
+				  TS_INDEX2VAL(XMIT_SZ_8BIT),
+		.mid_rid	= 0x35,
+	}, {
+		.slave_id	= SHDMA_SLAVE_SCIF5_RX,
+		.addr		= 0xa4e50024,
+		.chcr		= DM_INC | SM_FIX | 0x800 |
+				  TS_INDEX2VAL(XMIT_SZ_8BIT),
+		.mid_rid	= 0x36,
+	}, {
+		.slave_id	= SHDMA_SLAVE_SDHI0_TX,
+		.addr		= 0x04ce0030,
+		.chcr		= DM_FIX | SM_INC | 0x800 |
+				  TS_INDEX2VAL(XMIT_SZ_16BIT),
+		.mid_rid	= 0xc1,
+	}, {
+		.slave_id	= SHDMA_SLAVE_SDHI0_RX,
+		.addr		= 0x04ce0030,
+		.chcr		= DM_INC | SM_FIX | 0x800 |
+				  TS_INDEX2VAL(XMIT_SZ_16BIT),
+		.mid_rid	= 0xc2,
+	}, {
+		.slave_id	= SHDMA_SLAVE_SDHI1_TX,
+		.addr		= 0x04cf0030,
+		.chcr		= DM_FIX | SM_INC | 0x800 |
+				  TS_INDEX2VAL(XMIT_SZ_16BIT),
+		.mid_rid	= 0xc9,
+	}, {
+		.slave_id	= SHDMA_SLAVE_SDHI1_RX,
+		.addr		= 0x04cf0030,
+		.chcr		= DM_INC | SM_FIX | 0x800 |
+				  TS_INDEX2VAL(XMIT_SZ_16BIT),
+		.mid_rid	= 0xca,
+	}, {
+		.slave_id	= SHDMA_SLAVE_MSIOF0_TX,
+		.addr		= 0xa4c40050,
+		.chcr		= DM_FIX | SM_INC | 0x800 |
+				  TS_INDEX2VAL(XMIT_SZ_32BIT),
+		.mid_rid	= 0x51,
+	}, {
+		.slave_id	= SHDMA_SLAVE_MSIOF0_RX,
+		.addr		= 0xa4c40060,
+		.chcr		= DM_INC | SM_FIX | 0x800 |
+				  TS_INDEX2VAL(XMIT_SZ_32BIT),
+		.mid_rid	= 0x52,
+	}, {
+		.slave_id	= SHDMA_SLAVE_MSIOF1_TX,
+		.addr		= 0xa4c50050,
+		.chcr		= DM_FIX | SM_INC | 0x800 |
+				  TS_INDEX2VAL(XMIT_SZ_32BIT),
+		.mid_rid	= 0x55,
+	}, {
+		.slave_id	= SHDMA_SLAVE_MSIOF1_RX,
+		.addr		= 0xa4c50060,
+		.chcr		= DM_INC | SM_FIX | 0x800 |
+				  TS_INDEX2VAL(XMIT_SZ_32BIT),
+		.mid_rid	= 0x56,
+	}, {
+		.slave_id	= SHDMA_SLAVE_FSIA_TX,
+		.addr		= 0xfe3c0024,
+		.chcr		= DM_FIX | SM_INC | 0x800 |
+				  TS_INDEX2VAL(XMIT_SZ_32BIT),
+		.mid_rid	= 0xb1,
+	}, {
+		.slave_id	= SHDMA_SLAVE_FSIA_RX,
+		.addr		= 0xfe3c0020,
+		.chcr		= DM_INC | SM_FIX | 0x800 |
+				  TS_INDEX2VAL(XMIT_SZ_32BIT),
+		.mid_rid	= 0xb2,
+	}, {
+		.slave_id	= SHDMA_SLAVE_FSIB_TX,
+		.addr		= 0xfe3c0064,
+		.chcr		= DM_FIX | SM_INC | 0x800 |
+				  TS_INDEX2VAL(XMIT_SZ_32BIT),
+		.mid_rid	= 0xb5,
+	}, {
+		.slave_id	= SHDMA_SLAVE_FSIB_RX,
+		.addr		= 0xfe3c0060,
+		.chcr		= DM_INC | SM_FIX | 0x800 |
+				  TS_INDEX2VAL(XMIT_SZ_32BIT),
+		.mid_rid	= 0xb6,
+	},
+};
+
 static struct sh_dmae_pdata dma_platform_data = {
-	.mode = SHDMA_DMAOR1,
+	.mode		= SHDMA_DMAOR1 | SHDMA_RELOAD,
+	.config		= sh7724_dmae_slaves,
+	.config_num	= ARRAY_SIZE(sh7724_dmae_slaves),
 };
 
 static struct platform_device dma_device = {
@@ -95,6 +245,8 @@ static struct plat_sci_port scif3_platform_data = {
 	.type           = PORT_SCIFA,
 	.irqs           = { 56, 56, 56, 56 },
 	.clk		= "scif3",
+	.dma_slave_tx	= SHDMA_SLAVE_SCIF3_TX,
+	.dma_slave_rx	= SHDMA_SLAVE_SCIF3_RX,
 };
 
 static struct platform_device scif3_device = {
@@ -111,6 +263,8 @@ static struct plat_sci_port scif4_platform_data = {
 	.type           = PORT_SCIFA,
 	.irqs           = { 88, 88, 88, 88 },
 	.clk		= "scif4",
+	.dma_slave_tx	= SHDMA_SLAVE_SCIF4_TX,
+	.dma_slave_rx	= SHDMA_SLAVE_SCIF4_RX,
 };
 
 static struct platform_device scif4_device = {
@@ -127,6 +281,8 @@ static struct plat_sci_port scif5_platform_data = {
 	.type           = PORT_SCIFA,
 	.irqs           = { 109, 109, 109, 109 },
 	.clk		= "scif5",
+	.dma_slave_tx	= SHDMA_SLAVE_SCIF5_TX,
+	.dma_slave_rx	= SHDMA_SLAVE_SCIF5_RX,
 };
 
 static struct platform_device scif5_device = {
@@ -253,12 +409,22 @@ static struct platform_device vpu_device = {
 	},
 };
 
+/*
+ * The VEUs go to the V4L2 mem2mem driver when it is built,
+ * otherwise user space drives them through UIO.
+ */
+#if defined(CONFIG_VIDEO_SH_VEU) || defined(CONFIG_VIDEO_SH_VEU_MODULE)
+#define SH7724_VEU_V4L2
+#endif
+
 /* VEU0 */
+#ifndef SH7724_VEU_V4L2
 static struct uio_info veu0_platform_data = {
 	.name = "VEU3F0",
 	.version = "0",
 	.irq = 83,
 };
+#endif
 
 static struct resource veu0_resources[] = {
 	[0] = {
@@ -268,16 +434,25 @@ static struct resource veu0_resources[] = {
 		.flags	= IORESOURCE_MEM,
 	},
 	[1] = {
+		.start	= 83,
+		.flags	= IORESOURCE_IRQ,
+	},
+	[2] = {
 		/* place holder for contiguous memory */
 	},
 };
 
 static struct platform_device veu0_device = {
+#ifdef SH7724_VEU_V4L2
+	.name		= "sh_veu",
+	.id		= 0,
+#else
 	.name		= "uio_pdrv_genirq",
 	.id		= 1,
 	.dev = {
 		.platform_data	= &veu0_platform_data,
 	},
+#endif
 	.resource	= veu0_resources,
 	.num_resources	= ARRAY_SIZE(veu0_resources),
 	.archdata = {
@@ -286,11 +461,13 @@ static struct platform_device veu0_device = {
 };
 
 /* VEU1 */
+#ifndef SH7724_VEU_V4L2
 static struct uio_info veu1_platform_data = {
 	.name = "VEU3F1",
 	.version = "0",
 	.irq = 54,
 };
+#endif
 
 static struct resource veu1_resources[] = {
 	[0] = {
@@ -300,16 +477,25 @@ static struct resource veu1_resources[] = {
 		.flags	= IORESOURCE_MEM,
 	},
 	[1] = {
+		.start	= 54,
+		.flags	= IORESOURCE_IRQ,
+	},
+	[2] = {
 		/* place holder for contiguous memory */
 	},
 };
 
 static struct platform_device veu1_device = {
+#ifdef SH7724_VEU_V4L2
+	.name		= "sh_veu",
+	.id		= 1,
+#else
 	.name		= "uio_pdrv_genirq",
 	.id		= 2,
 	.dev = {
 		.platform_data	= &veu1_platform_data,
 	},
+#endif
 	.resource	= veu1_resources,
 	.num_resources	= ARRAY_SIZE(veu1_resources),
 	.archdata = {
@@ -24,13 +24,18 @@
 #include <linux/init.h>
 #include <linux/io.h>
 #include <linux/irq.h>
+#include <linux/hrtimer.h>
 #include <linux/perf_event.h>
 #include <asm/processor.h>
+#include <asm/irq_regs.h>
 
 struct cpu_hw_events {
 	struct perf_event	*events[MAX_HWEVENTS];
 	unsigned long		used_mask[BITS_TO_LONGS(MAX_HWEVENTS)];
 	unsigned long		active_mask[BITS_TO_LONGS(MAX_HWEVENTS)];
+	unsigned long		throttled_mask[BITS_TO_LONGS(MAX_HWEVENTS)];
+	struct hrtimer		poll_timer;
+	u64			poll_period;	/* ns the timer was armed for */
 };
 
 DEFINE_PER_CPU(struct cpu_hw_events, cpu_hw_events);
@@ -109,14 +114,6 @@ static int __hw_perf_event_init(struct perf_event *event)
 	if (!sh_pmu_initialized())
 		return -ENODEV;
 
-	/*
-	 * All of the on-chip counters are "limited", in that they have
-	 * no interrupts, and are therefore unable to do sampling without
-	 * further work and timer assistance.
-	 */
-	if (hwc->sample_period)
-		return -EINVAL;
-
 	/*
 	 * See if we need to reserve the counter.
 	 *
@@ -170,7 +167,7 @@ static void sh_perf_event_update(struct perf_event *event,
 {
 	u64 prev_raw_count, new_raw_count;
 	s64 delta;
-	int shift = 0;
+	int shift = 64 - sh_pmu->counter_width;
 
 	/*
 	 * Depending on the counter configuration, they may or may not
@@ -182,7 +179,9 @@ static void sh_perf_event_update(struct perf_event *event,
 	 * count to the generic counter atomically.
 	 *
 	 * As there is no interrupt associated with the overflow events,
-	 * this is the simplest approach for maintaining consistency.
+	 * this is the simplest approach for maintaining consistency. The
+	 * poll timer below reads the counters before they can move by
+	 * half their range, so the delta is always right.
 	 */
 again:
 	prev_raw_count = atomic64_read(&hwc->prev_count);
@@ -204,6 +203,108 @@ again:
 	delta >>= shift;
 
 	atomic64_add(delta, &event->count);
+	atomic64_sub(delta, &hwc->period_left);
+}
+
+/*
+ * None of the on-chip counters can raise an interrupt on overflow, so
+ * while any of them are in use a per-CPU hrtimer reads them back. With
+ * a sampling event active it runs every SH_PMU_SAMPLE_NS, and whenever
+ * an event has used up its sample period a sample is taken against the
+ * registers the timer interrupted, weighted by the number of events
+ * counted since the last one. Otherwise it only runs often enough to
+ * keep up with counter wrap.
+ */
+#define SH_PMU_SAMPLE_NS	NSEC_PER_MSEC
+#define SH_PMU_WRAP_NS		NSEC_PER_SEC
+
+static u64 sh_pmu_poll_period(struct cpu_hw_events *cpuc)
+{
+	int idx;
+
+	for_each_bit(idx, cpuc->active_mask, sh_pmu->num_events)
+		if (cpuc->events[idx]->hw.sample_period)
+			return SH_PMU_SAMPLE_NS;
+
+	return SH_PMU_WRAP_NS;
+}
+
+static void sh_pmu_sample(struct perf_event *event, struct pt_regs *regs)
+{
+	struct cpu_hw_events *cpuc = &__get_cpu_var(cpu_hw_events);
+	struct hw_perf_event *hwc = &event->hw;
+	struct perf_sample_data data;
+	s64 left = atomic64_read(&hwc->period_left);
+
+	if (left > 0 || test_bit(hwc->idx, cpuc->throttled_mask))
+		return;
+
+	data.addr = 0;
+	data.raw = NULL;
+	data.period = hwc->sample_period - left;
+
+	hwc->last_period = hwc->sample_period;
+	atomic64_set(&hwc->period_left, hwc->sample_period);
+
+	/*
+	 * In case we exclude kernel IPs or are somehow not in interrupt
+	 * context, provide the next best thing, the user IP.
+	 */
+	if ((event->attr.exclude_kernel || !regs) &&
+	    !event->attr.exclude_user)
+		regs = task_pt_regs(current);
+
+	if (!regs || (event->attr.exclude_idle && current->pid == 0))
+		return;
+
+	if (perf_event_overflow(event, 0, &data, regs))
+		set_bit(hwc->idx, cpuc->throttled_mask);
+}
+
+static enum hrtimer_restart sh_pmu_poll(struct hrtimer *timer)
+{
+	struct cpu_hw_events *cpuc =
+		container_of(timer, struct cpu_hw_events, poll_timer);
+	struct pt_regs *regs = get_irq_regs();
+	int idx;
+
+	if (bitmap_empty(cpuc->active_mask, MAX_HWEVENTS))
+		return HRTIMER_NORESTART;
+
+	for_each_bit(idx, cpuc->active_mask, sh_pmu->num_events) {
+		struct perf_event *event = cpuc->events[idx];
+
+		sh_perf_event_update(event, &event->hw, idx);
+
+		if (event->hw.sample_period)
+			sh_pmu_sample(event, regs);
+	}
+
+	cpuc->poll_period = sh_pmu_poll_period(cpuc);
+	hrtimer_forward_now(timer, ns_to_ktime(cpuc->poll_period));
+
+	return HRTIMER_RESTART;
+}
+
+/*
+ * Called with interrupts disabled and possibly under the runqueue lock,
+ * so no softirq wakeup, and the timer can't be running on this CPU.
+ *
+ * Events are enabled on every context switch, so a timer that is
+ * already running at the period needed is left alone; pushing it out
+ * each time would starve tasks that switch often of samples. It is only
+ * rearmed when the first sampling event shows up on a slow timer.
+ */
+static void sh_pmu_start_poll(struct cpu_hw_events *cpuc)
+{
+	u64 period = sh_pmu_poll_period(cpuc);
+
+	if (hrtimer_active(&cpuc->poll_timer) && cpuc->poll_period <= period)
+		return;
+
+	cpuc->poll_period = period;
+	__hrtimer_start_range_ns(&cpuc->poll_timer, ns_to_ktime(period), 0,
+				 HRTIMER_MODE_REL_PINNED, 0);
 }
 
 static void sh_pmu_disable(struct perf_event *event)
@@ -222,6 +323,9 @@ static void sh_pmu_disable(struct perf_event *event)
 	cpuc->events[idx] = NULL;
 	clear_bit(idx, cpuc->used_mask);
 
+	if (bitmap_empty(cpuc->active_mask, MAX_HWEVENTS))
+		hrtimer_try_to_cancel(&cpuc->poll_timer);
+
 	perf_event_update_userpage(event);
 }
 
@@ -242,11 +346,25 @@ static int sh_pmu_enable(struct perf_event *event)
 
 	sh_pmu->disable(hwc, idx);
 
+	/* Enabling a counter clears it */
+	atomic64_set(&hwc->prev_count, 0);
+
+	if (hwc->sample_period) {
+		s64 left = atomic64_read(&hwc->period_left);
+
+		if (left <= 0 || left > hwc->sample_period)
+			atomic64_set(&hwc->period_left, hwc->sample_period);
+		hwc->last_period = hwc->sample_period;
+	}
+
 	cpuc->events[idx] = event;
+	clear_bit(idx, cpuc->throttled_mask);
 	set_bit(idx, cpuc->active_mask);
 
 	sh_pmu->enable(hwc, idx);
 
+	sh_pmu_start_poll(cpuc);
+
 	perf_event_update_userpage(event);
 
 	return 0;
@@ -257,10 +375,20 @@ static void sh_pmu_read(struct perf_event *event)
 	sh_perf_event_update(event, &event->hw, event->hw.idx);
 }
 
+static void sh_pmu_unthrottle(struct perf_event *event)
+{
+	struct cpu_hw_events *cpuc = &__get_cpu_var(cpu_hw_events);
+
+	/* Don't weigh the first sample with everything since the throttle */
+	atomic64_set(&event->hw.period_left, event->hw.sample_period);
+	clear_bit(event->hw.idx, cpuc->throttled_mask);
+}
+
 static const struct pmu pmu = {
 	.enable		= sh_pmu_enable,
 	.disable	= sh_pmu_disable,
 	.read		= sh_pmu_read,
+	.unthrottle	= sh_pmu_unthrottle,
 };
 
 const struct pmu *hw_perf_event_init(struct perf_event *event)
@@ -280,6 +408,9 @@ void hw_perf_event_setup(int cpu)
 	struct cpu_hw_events *cpuhw = &per_cpu(cpu_hw_events, cpu);
 
 	memset(cpuhw, 0, sizeof(struct cpu_hw_events));
+
+	hrtimer_init(&cpuhw->poll_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	cpuhw->poll_timer.function = sh_pmu_poll;
 }
 
 void hw_perf_enable(void)
@@ -0,0 +1,209 @@
+/*
+ * arch/sh/kernel/selftest/atomic64.c - LL/SC atomic64_t under contention
+ *
+ * Times the LL/SC atomic64_t implementation against a copy of the
+ * generic hashed spinlock version from lib/atomic64.c. On UP the only
+ * contention an atomic64_t ever sees comes from interrupt context, so
+ * the contended runs have an hrtimer hammering the same counter while
+ * the loop is running. Every run also checks that no update got lost,
+ * which is what the single-word reservation has to guarantee.
+ *
+ * This file is subject to the terms and conditions of the GNU General Public
+ * License.  See the file "COPYING" in the main directory of this archive
+ * for more details.
+ */
+#include <linux/kernel.h>
+#include <linux/spinlock.h>
+#include <linux/hrtimer.h>
+#include <linux/ktime.h>
+#include <linux/cache.h>
+#include <asm/atomic.h>
+#include <asm/div64.h>
+#include "selftest.h"
+
+#define ITERATIONS	(1 << 20)
+#define IRQ_PERIOD_NS	20000
+
+#define NR_LOCKS	16
+
+static union {
+	spinlock_t lock;
+	char pad[L1_CACHE_BYTES];
+} bench_lock[NR_LOCKS] __cacheline_aligned_in_smp;
+
+static inline spinlock_t *lock_addr(const atomic64_t *v)
+{
+	unsigned long addr = (unsigned long) v;
+
+	addr >>= L1_CACHE_SHIFT;
+	addr ^= (addr >> 8) ^ (addr >> 16);
+	return &bench_lock[addr & (NR_LOCKS - 1)].lock;
+}
+
+static long long generic_add_return(long long a, atomic64_t *v)
+{
+	unsigned long flags;
+	spinlock_t *lock = lock_addr(v);
+	long long val;
+
+	spin_lock_irqsave(lock, flags);
+	val = v->counter += a;
+	spin_unlock_irqrestore(lock, flags);
+	return val;
+}
+
+static long long generic_cmpxchg(atomic64_t *v, long long o, long long n)
+{
+	unsigned long flags;
+	spinlock_t *lock = lock_addr(v);
+	long long val;
+
+	spin_lock_irqsave(lock, flags);
+	val = v->counter;
+	if (val == o)
+		v->counter = n;
+	spin_unlock_irqrestore(lock, flags);
+	return val;
+}
+
+static atomic64_t bench_counter;
+static int bench_generic;
+static unsigned long bench_irqs;
+static struct hrtimer bench_timer;
+
+static enum hrtimer_restart bench_timer_fn(struct hrtimer *timer)
+{
+	if (bench_generic)
+		generic_add_return(1, &bench_counter);
+	else
+		atomic64_add_return(1, &bench_counter);
+
+	bench_irqs++;
+
+	hrtimer_forward_now(timer, ns_to_ktime(IRQ_PERIOD_NS));
+	return HRTIMER_RESTART;
+}
+
+enum {
+	BENCH_ADD,
+	BENCH_ADD_CARRY,
+	BENCH_CMPXCHG,
+};
+
+static const char *bench_names[] = {
+	[BENCH_ADD]		= "add_return",
+	[BENCH_ADD_CARRY]	= "add_return (carry)",
+	[BENCH_CMPXCHG]		= "cmpxchg loop",
+};
+
+/* Crosses into the high word every other iteration */
+#define CARRY		(1LL << 31)
+
+static u64 bench_run(int test, int generic)
+{
+	ktime_t start;
+	unsigned int i;
+	long long old;
+
+	bench_generic = generic;
+	atomic64_set(&bench_counter, 0);
+	start = ktime_get();
+
+	for (i = 0; i < ITERATIONS; i++) {
+		switch (test) {
+		case BENCH_ADD:
+			if (generic)
+				generic_add_return(1, &bench_counter);
+			else
+				atomic64_add_return(1, &bench_counter);
+			break;
+		case BENCH_ADD_CARRY:
+			if (generic)
+				generic_add_return(CARRY, &bench_counter);
+			else
+				atomic64_add_return(CARRY, &bench_counter);
+			break;
+		case BENCH_CMPXCHG:
+			old = atomic64_read(&bench_counter);
+			if (generic) {
+				while (generic_cmpxchg(&bench_counter,
+						       old, old + 1) != old)
+					old = atomic64_read(&bench_counter);
+			} else {
+				while (atomic64_cmpxchg(&bench_counter,
+							old, old + 1) != old)
+					old = atomic64_read(&bench_counter);
+			}
+			break;
+		}
+	}
+
+	return ktime_to_ns(ktime_sub(ktime_get(), start));
+}
+
+static int bench_report(int test, int contended)
+{
+	unsigned long irqs = 0;
+	long long expect, got;
+	int generic, ret = 0;
+	u64 ns[2];
+
+	for (generic = 0; generic < 2; generic++) {
+		bench_irqs = 0;
+
+		if (contended)
+			hrtimer_start(&bench_timer, ns_to_ktime(IRQ_PERIOD_NS),
+				      HRTIMER_MODE_REL);
+
+		ns[generic] = bench_run(test, generic);
+
+		if (contended)
+			hrtimer_cancel(&bench_timer);
+
+		expect = (test == BENCH_ADD_CARRY ? CARRY : 1) *
+			 (long long)ITERATIONS + bench_irqs;
+		got = atomic64_read(&bench_counter);
+		if (got != expect) {
+			printk(KERN_ERR "sh-selftest: atomic64: %s %s: "
+			       "counter %lld, expected %lld\n",
+			       bench_names[test], generic ? "generic" : "llsc",
+			       got, expect);
+			ret = -EINVAL;
+		}
+
+		irqs += bench_irqs;
+
+		do_div(ns[generic], ITERATIONS);
+	}
+
+	printk(KERN_INFO "sh-selftest: atomic64: %-20s %-11s llsc %4llu ns, "
+	       "generic %4llu ns (%lu timer hits)\n", bench_names[test],
+	       contended ? "contended" : "uncontended",
+	       ns[0], ns[1], irqs);
+
+	return ret;
+}
+
+static int atomic64_selftest(void)
+{
+	int i, test, ret = 0;
+
+	for (i = 0; i < NR_LOCKS; i++)
+		spin_lock_init(&bench_lock[i].lock);
+
+	hrtimer_init(&bench_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	bench_timer.function = bench_timer_fn;
+
+	for (test = 0; test < ARRAY_SIZE(bench_names); test++) {
+		ret |= bench_report(test, 0);
+		ret |= bench_report(test, 1);
+	}
+
+	return ret;
+}
+
+const struct sh_selftest sh_selftest_atomic64 = {
+	.name	= "atomic64",
+	.desc	= "LL/SC atomic64_t vs. generic, with and without irq contention",
+	.run	= atomic64_selftest,
+};
@@ -0,0 +1,130 @@
+/*
+ * arch/sh/kernel/selftest/core.c - SH self-tests and benchmarks
+ *
+ * Reading the selftest file in the sh debugfs directory lists the tests
+ * built in, writing a test name, or "all", runs it. Tests check the SH
+ * specific implementations of generic interfaces against a reference,
+ * and time them against the code they replaced where that is still
+ * around. Everything is reported through the kernel log.
+ *
+ * This file is subject to the terms and conditions of the GNU General Public
+ * License.  See the file "COPYING" in the main directory of this archive
+ * for more details.
+ */
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/string.h>
+#include <linux/mutex.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/uaccess.h>
+#include <asm/system.h>
+#include "selftest.h"
+
+static const struct sh_selftest *sh_selftests[] = {
+#ifdef CONFIG_ATOMIC64_LLSC
+	&sh_selftest_atomic64,
+#endif
+	&sh_selftest_csum,
+	&sh_selftest_intc,
+	&sh_selftest_ktime,
+#if defined(CONFIG_CPU_SH4A) && defined(CONFIG_MMU)
+	&sh_selftest_page,
+#endif
+	&sh_selftest_sched_clock,
+};
+
+/* Tests share timers and buffers, one at a time */
+static DEFINE_MUTEX(sh_selftest_mutex);
+
+static int sh_selftest_run(const struct sh_selftest *t)
+{
+	int ret;
+
+	printk(KERN_INFO "sh-selftest: %s: %s\n", t->name, t->desc);
+
+	ret = t->run();
+	if (ret)
+		printk(KERN_ERR "sh-selftest: %s: FAILED (%d)\n",
+		       t->name, ret);
+	else
+		printk(KERN_INFO "sh-selftest: %s: passed\n", t->name);
+
+	return ret;
+}
+
+static int sh_selftest_seq_show(struct seq_file *file, void *iter)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(sh_selftests); i++)
+		seq_printf(file, "%-12s %s\n", sh_selftests[i]->name,
+			   sh_selftests[i]->desc);
+
+	return 0;
+}
+
+static int sh_selftest_debugfs_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, sh_selftest_seq_show, inode->i_private);
+}
+
+static ssize_t sh_selftest_debugfs_write(struct file *file,
+					 const char __user *buf,
+					 size_t count, loff_t *ppos)
+{
+	char name[32], *p;
+	int i, found = 0, ret = 0;
+
+	if (count >= sizeof(name))
+		return -EINVAL;
+	if (copy_from_user(name, buf, count))
+		return -EFAULT;
+	name[count] = '\0';
+	p = strstrip(name);
+
+	mutex_lock(&sh_selftest_mutex);
+	for (i = 0; i < ARRAY_SIZE(sh_selftests); i++) {
+		int err;
+
+		if (strcmp(p, "all") && strcmp(p, sh_selftests[i]->name))
+			continue;
+
+		found = 1;
+		err = sh_selftest_run(sh_selftests[i]);
+		if (err && !ret)
+			ret = err;
+	}
+	mutex_unlock(&sh_selftest_mutex);
+
+	if (!found)
+		return -EINVAL;
+
+	return ret ? ret : count;
+}
+
+static const struct file_operations sh_selftest_debugfs_fops = {
+	.owner		= THIS_MODULE,
+	.open		= sh_selftest_debugfs_open,
+	.read		= seq_read,
+	.write		= sh_selftest_debugfs_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init sh_selftest_init(void)
+{
+	struct dentry *dentry;
+
+	dentry = debugfs_create_file("selftest", S_IRUSR | S_IWUSR,
+				     sh_debugfs_root, NULL,
+				     &sh_selftest_debugfs_fops);
+	if (!dentry)
+		return -ENOMEM;
+	if (IS_ERR(dentry))
+		return PTR_ERR(dentry);
+
+	return 0;
+}
+module_init(sh_selftest_init);
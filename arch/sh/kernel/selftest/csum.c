@@ -0,0 +1,226 @@
+/*
+ * arch/sh/kernel/selftest/csum.c - csum_partial self-test and benchmark
+ *
+ * Checks csum_partial() and csum_partial_copy_nocheck() against a
+ * plain C reference for every source and destination alignment within
+ * a long word and a spread of lengths, also making sure the copy
+ * leaves the bytes around the destination alone. Then reports MB/s
+ * for both, at the alignments an sh_eth receive path sees, next to the
+ * reference implementation.
+ *
+ * This file is subject to the terms and conditions of the GNU General Public
+ * License.  See the file "COPYING" in the main directory of this archive
+ * for more details.
+ */
+#include <linux/kernel.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/ktime.h>
+#include <linux/random.h>
+#include <net/checksum.h>
+#include <asm/div64.h>
+#include "selftest.h"
+
+#define BUF_SIZE	8192
+#define GUARD		16
+#define POISON		0xa5
+
+#define BENCH_LEN	1500	/* bytes per call, a full Ethernet payload */
+#define BENCH_LOOPS	4096	/* calls per run */
+
+static const unsigned int test_lens[] = {
+	255, 256, 257, 511, 1023, 1499, 1500, 1514, 4000,
+};
+
+/*
+ * Reference: sum of the 16-bit words in memory order, folded.
+ */
+static u16 ref_csum(const u8 *p, int len, u32 sum)
+{
+	u64 s = (sum >> 16) + (sum & 0xffff);
+	int i;
+
+	for (i = 0; i + 1 < len; i += 2)
+#ifdef __LITTLE_ENDIAN__
+		s += p[i] | (p[i + 1] << 8);
+#else
+		s += (p[i] << 8) | p[i + 1];
+#endif
+
+	if (len & 1)
+#ifdef __LITTLE_ENDIAN__
+		s += p[len - 1];
+#else
+		s += p[len - 1] << 8;
+#endif
+
+	while (s >> 16)
+		s = (s & 0xffff) + (s >> 16);
+
+	return s;
+}
+
+static int csum_equal(__wsum sum, u16 ref)
+{
+	u16 folded = (__force u16)~csum_fold(sum);
+
+	/* 0 and 0xffff are the same thing in one's complement */
+	return folded == ref || (folded | ref) == 0xffff;
+}
+
+static int test_one(u8 *src, u8 *dst, int soff, int doff, int len)
+{
+	const u32 seed = 0x12345678;
+	u8 *s = src + GUARD + soff;
+	u8 *d = dst + GUARD + doff;
+	u16 ref = ref_csum(s, len, seed);
+	__wsum sum;
+	int i;
+
+	sum = csum_partial(s, len, (__force __wsum)seed);
+	if (!csum_equal(sum, ref)) {
+		printk(KERN_ERR "sh-selftest: csum: csum_partial off %d len %d: "
+		       "%04x, expected %04x\n", soff, len,
+		       (__force u16)~csum_fold(sum), ref);
+		return -EINVAL;
+	}
+
+	memset(dst, POISON, len + doff + 2 * GUARD);
+	sum = csum_partial_copy_nocheck(s, d, len, (__force __wsum)seed);
+	if (!csum_equal(sum, ref)) {
+		printk(KERN_ERR "sh-selftest: csum: csum_partial_copy src %d dst %d "
+		       "len %d: %04x, expected %04x\n", soff, doff, len,
+		       (__force u16)~csum_fold(sum), ref);
+		return -EINVAL;
+	}
+
+	if (memcmp(s, d, len)) {
+		printk(KERN_ERR "sh-selftest: csum: csum_partial_copy src %d dst %d "
+		       "len %d: bad copy\n", soff, doff, len);
+		return -EINVAL;
+	}
+
+	for (i = 0; i < GUARD + doff; i++)
+		if (dst[i] != POISON)
+			goto overrun;
+	for (i = GUARD + doff + len; i < len + doff + 2 * GUARD; i++)
+		if (dst[i] != POISON)
+			goto overrun;
+
+	return 0;
+
+overrun:
+	printk(KERN_ERR "sh-selftest: csum: csum_partial_copy src %d dst %d len %d: "
+	       "wrote outside the destination at %d\n", soff, doff, len,
+	       i - GUARD - doff);
+	return -EINVAL;
+}
+
+static int csum_selftest(u8 *src, u8 *dst)
+{
+	int soff, doff, len, i, ret;
+
+	for (soff = 0; soff < 4; soff++)
+		for (doff = 0; doff < 4; doff++) {
+			for (len = 0; len <= 128; len++) {
+				ret = test_one(src, dst, soff, doff, len);
+				if (ret)
+					return ret;
+			}
+			for (i = 0; i < ARRAY_SIZE(test_lens); i++) {
+				ret = test_one(src, dst, soff, doff,
+					       test_lens[i]);
+				if (ret)
+					return ret;
+			}
+		}
+
+	return 0;
+}
+
+static u64 bench_mbps(u64 ns)
+{
+	u64 bytes = (u64)BENCH_LEN * BENCH_LOOPS * 1000;
+
+	if (!ns)
+		return 0;
+
+	do_div(bytes, ns);
+	return bytes;
+}
+
+static void csum_bench(u8 *src, u8 *dst, int soff, int doff)
+{
+	u8 *s = src + GUARD + soff;
+	u8 *d = dst + GUARD + doff;
+	volatile u32 sink = 0;
+	ktime_t start;
+	u64 ns[4];
+	int i;
+
+	start = ktime_get();
+	for (i = 0; i < BENCH_LOOPS; i++)
+		sink += (__force u32)csum_partial(s, BENCH_LEN, 0);
+	ns[0] = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	start = ktime_get();
+	for (i = 0; i < BENCH_LOOPS; i++)
+		sink += ref_csum(s, BENCH_LEN, 0);
+	ns[1] = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	start = ktime_get();
+	for (i = 0; i < BENCH_LOOPS; i++)
+		sink += (__force u32)csum_partial_copy_nocheck(s, d,
+							       BENCH_LEN, 0);
+	ns[2] = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	start = ktime_get();
+	for (i = 0; i < BENCH_LOOPS; i++) {
+		memcpy(d, s, BENCH_LEN);
+		sink += ref_csum(d, BENCH_LEN, 0);
+	}
+	ns[3] = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	printk(KERN_INFO "sh-selftest: csum: src %d dst %d: csum %llu MB/s "
+	       "(reference %llu), csum+copy %llu MB/s (reference %llu)\n",
+	       soff, doff, bench_mbps(ns[0]), bench_mbps(ns[1]),
+	       bench_mbps(ns[2]), bench_mbps(ns[3]));
+}
+
+static int csum_selftest_run(void)
+{
+	u8 *src, *dst;
+	int ret;
+
+	src = kmalloc(BUF_SIZE, GFP_KERNEL);
+	dst = kmalloc(BUF_SIZE, GFP_KERNEL);
+	if (!src || !dst) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	get_random_bytes(src, BUF_SIZE);
+
+	ret = csum_selftest(src, dst);
+	if (ret)
+		goto out;
+
+	printk(KERN_INFO "sh-selftest: csum: all alignments passed\n");
+
+	csum_bench(src, dst, 0, 0);
+	csum_bench(src, dst, 2, 0);
+	csum_bench(src, dst, 0, 2);
+	csum_bench(src, dst, 1, 0);
+
+out:
+	kfree(dst);
+	kfree(src);
+
+	return ret;
+}
+
+const struct sh_selftest sh_selftest_csum = {
+	.name	= "csum",
+	.desc	= "csum_partial and csum_partial_copy vs. a C reference",
+	.run	= csum_selftest_run,
+};
@@ -0,0 +1,19 @@
+/*
+ * arch/sh/kernel/selftest/intc.c - INTC mask/unmask fast path
+ *
+ * The measurement itself lives in drivers/sh/intc.c, next to the
+ * intc_fast_irqs[] table it needs to get at.
+ *
+ * This file is subject to the terms and conditions of the GNU General Public
+ * License.  See the file "COPYING" in the main directory of this archive
+ * for more details.
+ */
+#include <linux/kernel.h>
+#include <linux/sh_intc.h>
+#include "selftest.h"
+
+const struct sh_selftest sh_selftest_intc = {
+	.name	= "intc",
+	.desc	= "INTC fast path coverage, unmask+mask cost vs. generic",
+	.run	= intc_selftest,
+};
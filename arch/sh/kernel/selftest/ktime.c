@@ -0,0 +1,100 @@
+/*
+ * arch/sh/kernel/selftest/ktime.c - ktime_get() and sched_clock() cost
+ *
+ * Reports the average cost of ktime_get() and sched_clock() on whatever
+ * clocksource is current, first on a quiet CPU and then with an hrtimer
+ * reading the time from interrupt context every IRQ_PERIOD_NS, which is
+ * where a read path that disables interrupts and takes a lock shows up.
+ * Both clocks are also checked for going backwards along the way.
+ *
+ * This file is subject to the terms and conditions of the GNU General Public
+ * License.  See the file "COPYING" in the main directory of this archive
+ * for more details.
+ */
+#include <linux/kernel.h>
+#include <linux/sched.h>
+#include <linux/ktime.h>
+#include <linux/hrtimer.h>
+#include <linux/math64.h>
+#include "selftest.h"
+
+#define LOOPS		100000	/* calls per measurement */
+#define IRQ_PERIOD_NS	100000	/* period of the interrupt context reader */
+
+static struct hrtimer bench_timer;
+static unsigned long bench_irqs;
+
+static enum hrtimer_restart bench_timer_fn(struct hrtimer *timer)
+{
+	ktime_get();
+	bench_irqs++;
+
+	hrtimer_forward_now(timer, ktime_set(0, IRQ_PERIOD_NS));
+
+	return HRTIMER_RESTART;
+}
+
+static int bench_run(const char *what)
+{
+	u64 ns[2], t, prev;
+	ktime_t start;
+	int i, ret = 0;
+
+	start = ktime_get();
+	prev = ktime_to_ns(start);
+	for (i = 0; i < LOOPS; i++) {
+		t = ktime_to_ns(ktime_get());
+		if (unlikely(t < prev))
+			ret = -EINVAL;
+		prev = t;
+	}
+	ns[0] = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	start = ktime_get();
+	prev = sched_clock();
+	for (i = 0; i < LOOPS; i++) {
+		t = sched_clock();
+		if (unlikely(t < prev))
+			ret = -EINVAL;
+		prev = t;
+	}
+	ns[1] = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	printk(KERN_INFO "sh-selftest: ktime: %-10s ktime_get() %llu ns, "
+	       "sched_clock() %llu ns\n", what,
+	       div_u64(ns[0], LOOPS), div_u64(ns[1], LOOPS));
+
+	if (ret)
+		printk(KERN_ERR "sh-selftest: ktime: %s time went backwards\n",
+		       what);
+
+	return ret;
+}
+
+static int ktime_selftest(void)
+{
+	int ret;
+
+	ret = bench_run("quiet:");
+
+	bench_irqs = 0;
+	hrtimer_init(&bench_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	bench_timer.function = bench_timer_fn;
+	hrtimer_start(&bench_timer, ktime_set(0, IRQ_PERIOD_NS),
+		      HRTIMER_MODE_REL);
+
+	ret = bench_run("irq load:") ? : ret;
+
+	hrtimer_cancel(&bench_timer);
+
+	printk(KERN_INFO "sh-selftest: ktime: %lu interrupt context reads\n",
+	       bench_irqs);
+
+	return ret;
+}
+
+const struct sh_selftest sh_selftest_ktime = {
+	.name	= "ktime",
+	.desc	= "ktime_get() and sched_clock() cost, quiet and under irq load",
+	.run	= ktime_selftest,
+};
@@ -0,0 +1,194 @@
+/*
+ * arch/sh/kernel/selftest/page.c - SH-4A copy_page/clear_page
+ *
+ * Checks every page copy and clear kernel available on SH-4A once, then
+ * reports its MB/s: the old generic copy_page and memset, the PREF/MOVCA.L
+ * integer versions and, with an FPU, the fmov.d pair move versions. The
+ * pages are spread over a buffer several times the size of the D-cache,
+ * so the numbers reflect cold sources and destinations.
+ *
+ * This file is subject to the terms and conditions of the GNU General Public
+ * License.  See the file "COPYING" in the main directory of this archive
+ * for more details.
+ */
+#include <linux/kernel.h>
+#include <linux/mm.h>
+#include <linux/slab.h>
+#include <linux/ktime.h>
+#include <linux/string.h>
+#include <asm/page.h>
+#include <asm/processor.h>
+#include <asm/fpu.h>
+#include <asm/div64.h>
+#include "selftest.h"
+
+#define NR_PAGES	256
+#define PASSES		16
+
+static void **bench_pages;
+
+static void bench_memset(void *to, void *from)
+{
+	memset(to, 0, PAGE_SIZE);
+}
+
+static void bench_clear(void *to, void *from)
+{
+	__clear_page_sh4a(to);
+}
+
+static void bench_copy(void *to, void *from)
+{
+	__copy_page_sh4a(to, from);
+}
+
+#ifdef CONFIG_SH_FPU
+static void bench_clear_fpu(void *to, void *from)
+{
+	__clear_page_sh4a_fpu(to);
+}
+
+static void bench_copy_fpu(void *to, void *from)
+{
+	__copy_page_sh4a_fpu(to, from);
+}
+#endif
+
+static const struct {
+	const char *name;
+	void (*fn)(void *to, void *from);
+	int copy;
+	int fpu;
+} bench_tests[] = {
+	{ "clear: memset",		bench_memset,		0, 0 },
+	{ "clear: movca",		bench_clear,		0, 0 },
+#ifdef CONFIG_SH_FPU
+	{ "clear: movca+fmov.d",	bench_clear_fpu,	0, 1 },
+#endif
+	{ "copy: generic",		__copy_page_generic,	1, 0 },
+	{ "copy: pref+movca",		bench_copy,		1, 0 },
+#ifdef CONFIG_SH_FPU
+	{ "copy: pref+movca+fmov.d",	bench_copy_fpu,		1, 1 },
+#endif
+};
+
+/*
+ * The FPU is claimed per page, as copy_page() does, so the cost of doing
+ * so is part of the result.
+ */
+static void bench_one(int test, void *to, void *from)
+{
+#ifdef CONFIG_SH_FPU
+	if (bench_tests[test].fpu)
+		kernel_fpu_begin();
+#endif
+	bench_tests[test].fn(to, from);
+#ifdef CONFIG_SH_FPU
+	if (bench_tests[test].fpu)
+		kernel_fpu_end();
+#endif
+}
+
+static int bench_check(int test)
+{
+	unsigned char *to = bench_pages[0], *from = bench_pages[1];
+	int i;
+
+	memset(to, 0x5a, PAGE_SIZE);
+	for (i = 0; i < PAGE_SIZE; i++)
+		from[i] = i ^ (i >> 8);
+
+	bench_one(test, to, from);
+
+	for (i = 0; i < PAGE_SIZE; i++)
+		if (to[i] != (bench_tests[test].copy ? from[i] : 0))
+			break;
+
+	if (i == PAGE_SIZE)
+		return 0;
+
+	printk(KERN_ERR "sh-selftest: page: %s: wrong byte at %d\n",
+	       bench_tests[test].name, i);
+	return -EINVAL;
+}
+
+static void bench_run(int test)
+{
+	unsigned int half = NR_PAGES / 2;
+	unsigned int i, pass;
+	ktime_t start;
+	u64 ns, bytes;
+
+	start = ktime_get();
+
+	for (pass = 0; pass < PASSES; pass++)
+		for (i = 0; i < half; i++)
+			bench_one(test, bench_pages[i], bench_pages[half + i]);
+
+	ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+	bytes = (u64)PASSES * half * PAGE_SIZE * 1000;
+	if (ns)
+		do_div(bytes, ns);
+	else
+		bytes = 0;
+
+	printk(KERN_INFO "sh-selftest: page: %-24s %5llu MB/s\n",
+	       bench_tests[test].name, bytes);
+}
+
+static void bench_free(unsigned int nr)
+{
+	while (nr--)
+		free_page((unsigned long)bench_pages[nr]);
+
+	kfree(bench_pages);
+}
+
+static int page_selftest(void)
+{
+	unsigned int i;
+	int test, ret = 0;
+
+	bench_pages = kmalloc(NR_PAGES * sizeof(void *), GFP_KERNEL);
+	if (!bench_pages)
+		return -ENOMEM;
+
+	for (i = 0; i < NR_PAGES; i++) {
+		bench_pages[i] = (void *)__get_free_page(GFP_KERNEL);
+		if (!bench_pages[i]) {
+			bench_free(i);
+			return -ENOMEM;
+		}
+		memset(bench_pages[i], i, PAGE_SIZE);
+	}
+
+#ifdef CONFIG_SH_FPU
+	if (!(boot_cpu_data.flags & CPU_HAS_FPU))
+		printk(KERN_INFO "sh-selftest: page: no FPU, "
+		       "skipping fmov.d runs\n");
+#endif
+
+	for (test = 0; test < ARRAY_SIZE(bench_tests); test++) {
+#ifdef CONFIG_SH_FPU
+		if (bench_tests[test].fpu &&
+		    !(boot_cpu_data.flags & CPU_HAS_FPU))
+			continue;
+#endif
+		if (bench_check(test)) {
+			ret = -EINVAL;
+			continue;
+		}
+
+		bench_run(test);
+	}
+
+	bench_free(NR_PAGES);
+
+	return ret;
+}
+
+const struct sh_selftest sh_selftest_page = {
+	.name	= "page",
+	.desc	= "copy_page/clear_page kernels, checked and timed",
+	.run	= page_selftest,
+};
@@ -0,0 +1,167 @@
+/*
+ * arch/sh/kernel/selftest/sched_clock.c - sched_clock() resolution and fairness
+ *
+ * First reports the smallest step sched_clock() takes, which is also
+ * the resolution of ftrace's local clock, next to the tick length it
+ * has to make do with when it only counts jiffies.
+ *
+ * Then runs a CPU hog next to a task that busy-loops for most of a tick
+ * and sleeps across every timer interrupt. With a tick based clock
+ * that task is hardly ever charged for the time it runs, and CFS hands
+ * it far more than its share; with a real clock the accounted runtime
+ * of both tasks matches what they actually used. The test fails when
+ * the dodger is charged for less than half the time it ran.
+ *
+ * This file is subject to the terms and conditions of the GNU General Public
+ * License.  See the file "COPYING" in the main directory of this archive
+ * for more details.
+ */
+#include <linux/kernel.h>
+#include <linux/sched.h>
+#include <linux/kthread.h>
+#include <linux/ktime.h>
+#include <linux/delay.h>
+#include <linux/completion.h>
+#include <linux/math64.h>
+#include "selftest.h"
+
+#define TEST_SECS	5	/* length of the fairness run */
+#define DODGE_PCT	80	/* part of each tick the dodger runs for */
+
+struct fair_task {
+	struct task_struct	*task;
+	u64			busy_ns;	/* measured with ktime_get() */
+	u64			charged_ns;	/* sum_exec_runtime */
+	struct completion	done;
+};
+
+static struct fair_task hog, dodger;
+static int fair_stop;
+
+static int hog_fn(void *arg)
+{
+	struct fair_task *ft = arg;
+	ktime_t start = ktime_get();
+	u64 exec_start = current->se.sum_exec_runtime;
+
+	while (!ACCESS_ONCE(fair_stop))
+		cpu_relax();
+
+	ft->busy_ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+	ft->charged_ns = current->se.sum_exec_runtime - exec_start;
+	complete(&ft->done);
+
+	while (!kthread_should_stop())
+		schedule_timeout_interruptible(1);
+
+	return 0;
+}
+
+static int dodger_fn(void *arg)
+{
+	struct fair_task *ft = arg;
+	const long burst_ns = NSEC_PER_SEC / HZ / 100 * DODGE_PCT;
+	u64 exec_start = current->se.sum_exec_runtime;
+	u64 busy = 0;
+
+	while (!ACCESS_ONCE(fair_stop)) {
+		ktime_t t0;
+
+		/* Wake up right after a tick... */
+		schedule_timeout_uninterruptible(1);
+
+		/* ...and be asleep again before the next one */
+		t0 = ktime_get();
+		while (ktime_to_ns(ktime_sub(ktime_get(), t0)) < burst_ns)
+			cpu_relax();
+		busy += ktime_to_ns(ktime_sub(ktime_get(), t0));
+	}
+
+	ft->busy_ns = busy;
+	ft->charged_ns = current->se.sum_exec_runtime - exec_start;
+	complete(&ft->done);
+
+	while (!kthread_should_stop())
+		schedule_timeout_interruptible(1);
+
+	return 0;
+}
+
+static void resolution_test(void)
+{
+	unsigned long long t0, t1, step = ULLONG_MAX;
+	int i;
+
+	for (i = 0; i < 1000; i++) {
+		t0 = sched_clock();
+		do {
+			t1 = sched_clock();
+		} while (t1 == t0);
+
+		step = min(step, t1 - t0);
+	}
+
+	printk(KERN_INFO "sh-selftest: sched_clock: resolution %llu ns, "
+	       "tick %lu ns\n", step, NSEC_PER_SEC / HZ);
+}
+
+static void fairness_report(const char *name, struct fair_task *ft)
+{
+	u32 busy_ms = div_u64(ft->busy_ns, NSEC_PER_MSEC);
+	u32 charged_ms = div_u64(ft->charged_ns, NSEC_PER_MSEC);
+
+	printk(KERN_INFO "sh-selftest: sched_clock: %-6s ran %u ms, "
+	       "charged %u ms (%u%%)\n", name, busy_ms, charged_ms,
+	       busy_ms ? charged_ms * 100 / busy_ms : 0);
+}
+
+static int fairness_test(void)
+{
+	fair_stop = 0;
+	init_completion(&hog.done);
+	init_completion(&dodger.done);
+
+	hog.task = kthread_create(hog_fn, &hog, "sclk-hog");
+	if (IS_ERR(hog.task))
+		return PTR_ERR(hog.task);
+
+	dodger.task = kthread_create(dodger_fn, &dodger, "sclk-dodger");
+	if (IS_ERR(dodger.task)) {
+		kthread_stop(hog.task);
+		return PTR_ERR(dodger.task);
+	}
+
+	kthread_bind(hog.task, raw_smp_processor_id());
+	kthread_bind(dodger.task, raw_smp_processor_id());
+	wake_up_process(hog.task);
+	wake_up_process(dodger.task);
+
+	ssleep(TEST_SECS);
+	fair_stop = 1;
+
+	wait_for_completion(&hog.done);
+	wait_for_completion(&dodger.done);
+	kthread_stop(hog.task);
+	kthread_stop(dodger.task);
+
+	fairness_report("hog", &hog);
+	fairness_report("dodger", &dodger);
+
+	if (dodger.charged_ns < dodger.busy_ns / 2)
+		return -EINVAL;
+
+	return 0;
+}
+
+static int sched_clock_selftest(void)
+{
+	resolution_test();
+
+	return fairness_test();
+}
+
+const struct sh_selftest sh_selftest_sched_clock = {
+	.name	= "sched_clock",
+	.desc	= "sched_clock() resolution and CFS fairness",
+	.run	= sched_clock_selftest,
+};
@@ -0,0 +1,21 @@
+#ifndef __SH_SELFTEST_H
+#define __SH_SELFTEST_H
+
+/*
+ * One entry in the debugfs selftest file. ->run() logs its results and
+ * returns 0, or a negative error if something didn't check out.
+ */
+struct sh_selftest {
+	const char	*name;
+	const char	*desc;
+	int		(*run)(void);
+};
+
+extern const struct sh_selftest sh_selftest_atomic64;
+extern const struct sh_selftest sh_selftest_csum;
+extern const struct sh_selftest sh_selftest_intc;
+extern const struct sh_selftest sh_selftest_ktime;
+extern const struct sh_selftest sh_selftest_page;
+extern const struct sh_selftest sh_selftest_sched_clock;
+
+#endif /* __SH_SELFTEST_H */
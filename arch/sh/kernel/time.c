@@ -20,9 +20,15 @@
 #include <linux/platform_device.h>
 #include <linux/smp.h>
 #include <linux/rtc.h>
+#include <linux/clocksource.h>
+#include <linux/math64.h>
+#include <linux/seqlock.h>
+#include <linux/spinlock.h>
+#include <linux/timer.h>
 #include <asm/clock.h>
 #include <asm/hwblk.h>
 #include <asm/rtc.h>
+#include <asm/sched_clock.h>
 
 /* Dummy RTC ops */
 static void null_rtc_get_time(struct timespec *tv)
@@ -88,6 +94,180 @@ static int __init rtc_generic_init(void)
 }
 module_init(rtc_generic_init);
 
+/*
+ * sched_clock() extends a free-running counter of up to 32 bits to 64
+ * bits of nanoseconds. The epoch is moved forward by a timer well before
+ * the counter can wrap, and readers only ever retry on the sequence
+ * count, so this is safe to call from any context, tracing included.
+ *
+ * Clocksource ->enable() and ->disable() run with xtime_lock held or
+ * under stop_machine(), so everything that may print or touch timers is
+ * done when the driver registers its counter, and starting and stopping
+ * it only switches the counter in and out under sched_clock_lock.
+ */
+static struct sh_sched_clock {
+	seqcount_t		seq;
+	struct clocksource	*cs;	/* NULL while counting jiffies */
+	u64			epoch_ns;
+	u64			epoch_cyc;
+	u64			mask;
+	u32			mult;
+	u32			shift;
+} sched_clock_data = {
+	.seq		= SEQCNT_ZERO,
+	.epoch_cyc	= INITIAL_JIFFIES,
+	.mask		= ~0ULL,
+	.mult		= NSEC_PER_SEC / HZ,
+};
+
+/* The registered counter, switched in by sh_sched_clock_start() */
+static struct clocksource *sched_clock_cs;
+static u32 sched_clock_cs_mult, sched_clock_cs_shift;
+
+/* Poll period in jiffies, for the fastest wrapping counter registered */
+static unsigned long sched_clock_period;
+
+static DEFINE_SPINLOCK(sched_clock_lock);
+
+static void sched_clock_poll(unsigned long unused);
+static DEFINE_TIMER(sched_clock_timer, sched_clock_poll, 0, 0);
+
+/*
+ * Without a counter this counts jiffies_64, so that nothing wraps when
+ * no timer driver ever moves the epoch forward. get_jiffies_64() can't
+ * be used as it takes xtime_lock, which the tick may hold around a call
+ * in here; reading the two halves until they agree does the job.
+ */
+static inline u64 notrace sched_clock_cyc(struct sh_sched_clock *cd)
+{
+	u64 j;
+
+	if (cd->cs)
+		return cd->cs->read(cd->cs);
+
+	do {
+		j = ACCESS_ONCE(jiffies_64);
+	} while (j != ACCESS_ONCE(jiffies_64));
+
+	return j;
+}
+
+static inline u64 notrace sched_clock_ns(struct sh_sched_clock *cd, u64 cyc)
+{
+	return cd->epoch_ns +
+		(((cyc - cd->epoch_cyc) & cd->mask) * cd->mult >> cd->shift);
+}
+
+unsigned long long notrace sched_clock(void)
+{
+	struct sh_sched_clock *cd = &sched_clock_data;
+	unsigned long long ns;
+	unsigned int seq;
+
+	do {
+		seq = read_seqcount_begin(&cd->seq);
+		ns = sched_clock_ns(cd, sched_clock_cyc(cd));
+	} while (read_seqcount_retry(&cd->seq, seq));
+
+	return ns;
+}
+
+/*
+ * Switch to @cs, or back to jiffies for NULL, carrying the current time
+ * over. Called with sched_clock_lock held and interrupts disabled.
+ */
+static void sched_clock_switch(struct clocksource *cs, u64 mask,
+			       u32 mult, u32 shift)
+{
+	struct sh_sched_clock *cd = &sched_clock_data;
+
+	write_seqcount_begin(&cd->seq);
+	cd->epoch_ns = sched_clock_ns(cd, sched_clock_cyc(cd));
+	cd->cs = cs;
+	cd->mask = mask;
+	cd->mult = mult;
+	cd->shift = shift;
+	cd->epoch_cyc = sched_clock_cyc(cd);
+	write_seqcount_end(&cd->seq);
+}
+
+static void sched_clock_poll(unsigned long unused)
+{
+	struct sh_sched_clock *cd = &sched_clock_data;
+	unsigned long flags;
+
+	spin_lock_irqsave(&sched_clock_lock, flags);
+	sched_clock_switch(cd->cs, cd->mask, cd->mult, cd->shift);
+	spin_unlock_irqrestore(&sched_clock_lock, flags);
+
+	mod_timer(&sched_clock_timer, jiffies + sched_clock_period);
+}
+
+/*
+ * Called from timer driver probe. @rate is what the counter will run at
+ * once sh_sched_clock_start() is called for it.
+ */
+void sh_sched_clock_register(struct clocksource *cs, unsigned long rate)
+{
+	unsigned long flags, period;
+	u32 mult, shift;
+	u64 wrap_ns;
+
+	if (cs->mask > 0xffffffff || !rate)
+		return;
+
+	clocks_calc_mult_shift(&mult, &shift, rate, NSEC_PER_SEC,
+			       div_u64(cs->mask + 1, rate));
+
+	/* Come back after half the time the counter takes to wrap */
+	wrap_ns = (cs->mask * mult) >> (shift + 1);
+	period = min_t(u64, div_u64(wrap_ns, NSEC_PER_SEC / HZ), 3600 * HZ);
+	period = max(period, 1UL);
+
+	spin_lock_irqsave(&sched_clock_lock, flags);
+	if (!sched_clock_period || period < sched_clock_period)
+		sched_clock_period = period;
+
+	if (sched_clock_cs && sched_clock_cs->rating >= cs->rating) {
+		spin_unlock_irqrestore(&sched_clock_lock, flags);
+		return;
+	}
+
+	sched_clock_cs = cs;
+	sched_clock_cs_mult = mult;
+	sched_clock_cs_shift = shift;
+	spin_unlock_irqrestore(&sched_clock_lock, flags);
+
+	mod_timer(&sched_clock_timer, jiffies + sched_clock_period);
+
+	pr_info("sched_clock: %s at %lu Hz, %u ns resolution\n",
+		cs->name, rate, (mult >> shift) ? : 1);
+}
+
+/*
+ * Called from clocksource ->enable() and ->disable(), in any context.
+ */
+void sh_sched_clock_start(struct clocksource *cs)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&sched_clock_lock, flags);
+	if (sched_clock_cs == cs)
+		sched_clock_switch(cs, cs->mask, sched_clock_cs_mult,
+				   sched_clock_cs_shift);
+	spin_unlock_irqrestore(&sched_clock_lock, flags);
+}
+
+void sh_sched_clock_stop(struct clocksource *cs)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&sched_clock_lock, flags);
+	if (sched_clock_data.cs == cs)
+		sched_clock_switch(NULL, ~0ULL, NSEC_PER_SEC / HZ, 0);
+	spin_unlock_irqrestore(&sched_clock_lock, flags);
+}
+
 void (*board_time_init)(void);
 
 static void __init sh_late_time_init(void)
@@ -0,0 +1,132 @@
+/*
+ * arch/sh/kernel/vsyscall/vsyscall-time.c
+ *
+ * gettimeofday() and clock_gettime() without a trap, for clocksources
+ * with a counter that user space may read. Everything else falls back
+ * to the syscall.
+ *
+ * This file is subject to the terms and conditions of the GNU General Public
+ * License.  See the file "COPYING" in the main directory of this archive
+ * for more details.
+ */
+#include <linux/time.h>
+#include <asm/unistd.h>
+#include <asm/page.h>
+#include <asm/vdso.h>
+
+#ifdef CONFIG_SMP
+#define vdso_rmb()	__asm__ __volatile__ ("synco" : : : "memory")
+#else
+#define vdso_rmb()	__asm__ __volatile__ ("" : : : "memory")
+#endif
+
+static const volatile struct vdso_data *vdso_get_data(void)
+{
+	/* The vDSO text fits in the first page, the data follows it */
+	return (const volatile struct vdso_data *)
+		(((unsigned long)vdso_get_data & PAGE_MASK) + PAGE_SIZE);
+}
+
+static long vdso_syscall2(long nr, long arg1, long arg2)
+{
+	register long r3 asm("r3") = nr;
+	register long r4 asm("r4") = arg1;
+	register long r5 asm("r5") = arg2;
+	register long r0 asm("r0");
+
+	__asm__ __volatile__ ("trapa	#0x12"
+			      : "=z" (r0)
+			      : "r" (r3), "r" (r4), "r" (r5)
+			      : "memory");
+
+	return r0;
+}
+
+static int vdso_read_time(struct timespec *ts, int monotonic)
+{
+	const volatile struct vdso_data *vd = vdso_get_data();
+	const volatile u32 *counter;
+	u32 seq, sec, nsec, delta, lo, hi;
+	u64 prod;
+	int shift;
+
+	do {
+		seq = vd->seq;
+		vdso_rmb();
+
+		if (unlikely(!vd->counter_valid))
+			return -1;
+
+		counter = (const volatile u32 *)((unsigned long)vd +
+						 PAGE_SIZE + vd->counter_offset);
+		delta = ((*counter ^ vd->counter_xor) - vd->cycle_last) &
+			vd->mask;
+		prod = (u64)delta * vd->mult;
+		shift = vd->shift;
+
+		sec = vd->wall_time_sec;
+		nsec = vd->wall_time_nsec;
+		if (monotonic) {
+			sec += vd->wall_to_mono_sec;
+			nsec += vd->wall_to_mono_nsec;
+		}
+
+		vdso_rmb();
+	} while (unlikely((seq & 1) || seq != vd->seq));
+
+	/* 64 bit shifts would need libgcc, delta is less than a few ticks */
+	lo = prod;
+	hi = prod >> 32;
+	if (shift)
+		lo = (hi << (32 - shift)) | (lo >> shift);
+	nsec += lo;
+
+	while (nsec >= NSEC_PER_SEC) {
+		nsec -= NSEC_PER_SEC;
+		sec++;
+	}
+
+	ts->tv_sec = sec;
+	ts->tv_nsec = nsec;
+
+	return 0;
+}
+
+int __vdso_clock_gettime(clockid_t clock, struct timespec *ts)
+{
+	switch (clock) {
+	case CLOCK_REALTIME:
+		if (!vdso_read_time(ts, 0))
+			return 0;
+		break;
+	case CLOCK_MONOTONIC:
+		if (!vdso_read_time(ts, 1))
+			return 0;
+		break;
+	}
+
+	return vdso_syscall2(__NR_clock_gettime, clock, (long)ts);
+}
+
+int __vdso_gettimeofday(struct timeval *tv, struct timezone *tz)
+{
+	const volatile struct vdso_data *vd = vdso_get_data();
+	struct timespec ts;
+
+	if (tv) {
+		if (vdso_read_time(&ts, 0))
+			return vdso_syscall2(__NR_gettimeofday,
+					     (long)tv, (long)tz);
+
+		/* nsec / 1000 without a libgcc division, exact below a second */
+		tv->tv_sec = ts.tv_sec;
+		tv->tv_usec = ((u64)ts.tv_nsec * 2199023256U) >> 41;
+	}
+
+	if (tz) {
+		tz->tz_minuteswest = vd->tz_minuteswest;
+		tz->tz_dsttime = vd->tz_dsttime;
+	}
+
+	return 0;
+}
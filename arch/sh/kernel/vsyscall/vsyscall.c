@@ -19,6 +19,11 @@
 #include <linux/elf.h>
 #include <linux/sched.h>
 #include <linux/err.h>
+#include <linux/mman.h>
+#include <linux/clocksource.h>
+#include <linux/time.h>
+#include <asm/cacheflush.h>
+#include <asm/vdso.h>
 
 /*
  * Should the kernel map a VDSO page into processes and pass its
@@ -39,11 +44,129 @@ __setup("vdso=", vdso_setup);
  * of the ELF DSO images included therein.
  */
 extern const char vsyscall_trapa_start, vsyscall_trapa_end;
-static struct page *syscall_pages[1];
+
+#ifdef CONFIG_GENERIC_TIME_VSYSCALL
+#define VSYSCALL_PAGES	2	/* text, struct vdso_data */
+#else
+#define VSYSCALL_PAGES	1
+#endif
+
+static struct page *syscall_pages[VSYSCALL_PAGES];
+
+#ifdef CONFIG_GENERIC_TIME_VSYSCALL
+static struct vdso_data *vdso_data;
+
+/* The one clocksource the vDSO knows how to read */
+static struct clocksource *vdso_clock;
+static unsigned long vdso_counter_pfn;
+static u32 vdso_counter_offset, vdso_counter_xor;
+
+/*
+ * Called by timer drivers whose clocksource is a plain memory mapped
+ * counter, before they register it. @addr is the register address from
+ * the platform resource, @xor is applied to the value read, ~0 for
+ * counters that count down.
+ *
+ * A clocksource the vDSO can read saves a system call on every time
+ * query, so @cs is rated one above its peers: a CMT and a TMU channel
+ * of equal rating would otherwise leave it to probe order which one is
+ * picked.
+ */
+void vdso_register_counter(struct clocksource *cs, unsigned long addr,
+			   u32 xor)
+{
+	if (!vdso_enabled)
+		return;
+
+	cs->rating++;
+
+	if (vdso_clock && vdso_clock->rating >= cs->rating)
+		return;
+
+#ifdef CONFIG_29BIT
+	/* P4 registers are reached through their area 7 mirror via the TLB */
+	addr &= 0x1fffffff;
+#endif
+
+	vdso_clock = cs;
+	vdso_counter_pfn = addr >> PAGE_SHIFT;
+	vdso_counter_offset = addr & ~PAGE_MASK;
+	vdso_counter_xor = xor;
+}
+
+/* Called with xtime_lock held for writing */
+void update_vsyscall(struct timespec *wall_time, struct clocksource *clock,
+		     u32 mult)
+{
+	struct vdso_data *vd = vdso_data;
+
+	if (unlikely(!vd))
+		return;
+
+	vd->seq++;
+	smp_wmb();
+
+	vd->counter_valid	= clock == vdso_clock;
+	vd->counter_offset	= vdso_counter_offset;
+	vd->counter_xor		= vdso_counter_xor;
+	vd->cycle_last		= clock->cycle_last;
+	vd->mask		= clock->mask;
+	vd->mult		= mult;
+	vd->shift		= clock->shift;
+	vd->wall_time_sec	= wall_time->tv_sec;
+	vd->wall_time_nsec	= wall_time->tv_nsec;
+	vd->wall_to_mono_sec	= wall_to_monotonic.tv_sec;
+	vd->wall_to_mono_nsec	= wall_to_monotonic.tv_nsec;
+
+	smp_wmb();
+	vd->seq++;
+}
+
+void update_vsyscall_tz(void)
+{
+	struct vdso_data *vd = vdso_data;
+
+	if (unlikely(!vd))
+		return;
+
+	vd->tz_minuteswest	= sys_tz.tz_minuteswest;
+	vd->tz_dsttime		= sys_tz.tz_dsttime;
+}
+
+/* Map the counter page read-only and uncached right after the data */
+static int vdso_map_counter(struct mm_struct *mm, unsigned long addr)
+{
+	struct vm_area_struct *vma;
+
+	vma = kmem_cache_zalloc(vm_area_cachep, GFP_KERNEL);
+	if (unlikely(!vma))
+		return -ENOMEM;
+
+	vma->vm_mm = mm;
+	vma->vm_start = addr;
+	vma->vm_end = addr + PAGE_SIZE;
+	vma->vm_flags = VM_READ | VM_MAYREAD | VM_DONTEXPAND;
+	vma->vm_page_prot = pgprot_noncached(vm_get_page_prot(vma->vm_flags));
+
+	if (unlikely(insert_vm_struct(mm, vma))) {
+		kmem_cache_free(vm_area_cachep, vma);
+		return -ENOMEM;
+	}
+
+	mm->total_vm++;
+
+	return io_remap_pfn_range(vma, addr, vdso_counter_pfn, PAGE_SIZE,
+				  vma->vm_page_prot);
+}
+#endif
 
 int __init vsyscall_init(void)
 {
 	void *syscall_page = (void *)get_zeroed_page(GFP_ATOMIC);
+
+	if (unlikely(!syscall_page))
+		goto fail;
+
 	syscall_pages[0] = virt_to_page(syscall_page);
 
 	/*
@@ -55,24 +178,61 @@ int __init vsyscall_init(void)
 	       &vsyscall_trapa_start,
 	       &vsyscall_trapa_end - &vsyscall_trapa_start);
 
+	/* The vDSO reads its GOT through a user mapping of another colour */
+	__flush_wback_region(syscall_page, PAGE_SIZE);
+
+#ifdef CONFIG_GENERIC_TIME_VSYSCALL
+	vdso_data = (struct vdso_data *)get_zeroed_page(GFP_ATOMIC);
+	if (unlikely(!vdso_data)) {
+		free_page((unsigned long)syscall_page);
+		goto fail;
+	}
+
+	syscall_pages[1] = virt_to_page(vdso_data);
+	update_vsyscall_tz();
+#endif
+
 	return 0;
+
+fail:
+	printk(KERN_ERR "vDSO: no memory for the vsyscall pages\n");
+	vdso_enabled = 0;
+
+	return -ENOMEM;
 }
 
 /* Setup a VMA at program startup for the vsyscall page */
 int arch_setup_additional_pages(struct linux_binprm *bprm, int uses_interp)
 {
 	struct mm_struct *mm = current->mm;
+	unsigned long len = VSYSCALL_PAGES << PAGE_SHIFT;
+	unsigned long pgoff = 0, flags = 0;
 	unsigned long addr;
 	int ret;
 
+	if (!vdso_enabled)
+		return 0;
+
+#ifdef CONFIG_GENERIC_TIME_VSYSCALL
+	if (vdso_clock)
+		len += PAGE_SIZE;
+
+	/*
+	 * The kernel rewrites the data page every tick, give its user
+	 * mapping the cache colour of the kernel one so no flush is needed.
+	 */
+	pgoff = ((unsigned long)vdso_data >> PAGE_SHIFT) - 1;
+	flags = MAP_SHARED;
+#endif
+
 	down_write(&mm->mmap_sem);
-	addr = get_unmapped_area(NULL, 0, PAGE_SIZE, 0, 0);
+	addr = get_unmapped_area(NULL, 0, len, pgoff, flags);
 	if (IS_ERR_VALUE(addr)) {
 		ret = addr;
 		goto up_fail;
 	}
 
-	ret = install_special_mapping(mm, addr, PAGE_SIZE,
+	ret = install_special_mapping(mm, addr, VSYSCALL_PAGES << PAGE_SHIFT,
 				      VM_READ | VM_EXEC |
 				      VM_MAYREAD | VM_MAYWRITE | VM_MAYEXEC |
 				      VM_ALWAYSDUMP,
@@ -80,6 +240,14 @@ int arch_setup_additional_pages(struct linux_binprm *bprm, int uses_interp)
 	if (unlikely(ret))
 		goto up_fail;
 
+#ifdef CONFIG_GENERIC_TIME_VSYSCALL
+	if (vdso_clock) {
+		ret = vdso_map_counter(mm, addr + (VSYSCALL_PAGES << PAGE_SHIFT));
+		if (unlikely(ret))
+			goto up_fail;
+	}
+#endif
+
 	current->mm->context.vdso = (void *)addr;
 
 up_fail:
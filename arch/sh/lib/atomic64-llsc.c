@@ -0,0 +1,283 @@
+/*
+ * arch/sh/lib/atomic64-llsc.c - 64-bit atomics for UP SH-4A
+ *
+ * movli.l/movco.l only reserve a single 32-bit word, so there is no
+ * way to commit a 64-bit value in one store-conditional. On UP this
+ * doesn't matter much: the reservation is dropped by any interrupt or
+ * exception, and that is the only way anybody else gets to touch the
+ * counter. Reserving the low word therefore also protects the high
+ * word for as long as the reservation holds, and any update that
+ * leaves the high word alone completes with a single movco.l.
+ *
+ * Every read-modify-write is one asm block from movli.l to movco.l, so
+ * the compiler can't put loads, stores or spills inside the sequence.
+ * An update that would change the high word leaves the block without
+ * storing anything, and is redone with interrupts disabled. Those are
+ * rare: a carry into (or a borrow from) the high word.
+ *
+ * This file is subject to the terms and conditions of the GNU General Public
+ * License.  See the file "COPYING" in the main directory of this archive
+ * for more details.
+ */
+#include <linux/types.h>
+#include <linux/compiler.h>
+#include <linux/irqflags.h>
+#include <linux/module.h>
+#include <asm/atomic.h>
+
+#ifdef CONFIG_CPU_LITTLE_ENDIAN
+#define LO_WORD		0
+#define HI_WORD		1
+#else
+#define LO_WORD		1
+#define HI_WORD		0
+#endif
+
+static inline u32 *atomic64_word(const atomic64_t *v, int word)
+{
+	return (u32 *)&v->counter + word;
+}
+
+static inline u32 hi_word(long long v)
+{
+	return (u32)((u64)v >> 32);
+}
+
+static inline long long make64(u32 hi, u32 lo)
+{
+	return ((u64)hi << 32) | lo;
+}
+
+long long atomic64_read(const atomic64_t *v)
+{
+	u32 hi, lo;
+
+	/* Anything that changes both words also changes the high word */
+	do {
+		hi = ACCESS_ONCE(*atomic64_word(v, HI_WORD));
+		lo = ACCESS_ONCE(*atomic64_word(v, LO_WORD));
+	} while (hi != ACCESS_ONCE(*atomic64_word(v, HI_WORD)));
+
+	return make64(hi, lo);
+}
+EXPORT_SYMBOL(atomic64_read);
+
+long long atomic64_xchg(atomic64_t *v, long long new)
+{
+	unsigned long flags;
+	u32 tmp, lo, hi;
+	long long old;
+
+	__asm__ __volatile__ (
+"1:	movli.l	@%3, %0		! atomic64_xchg	\n"
+"	mov.l	@%4, %2				\n"
+"	mov	%0, %1				\n"
+"	cmp/eq	%2, %6				\n"
+"	bf	2f				\n"
+"	mov	%5, %0				\n"
+"	movco.l	%0, @%3				\n"
+"	bf	1b				\n"
+"2:						\n"
+	: "=&z" (tmp), "=&r" (lo), "=&r" (hi)
+	: "r" (atomic64_word(v, LO_WORD)), "r" (atomic64_word(v, HI_WORD)),
+	  "r" ((u32)new), "r" (hi_word(new))
+	: "t", "memory");
+
+	if (likely(hi == hi_word(new)))
+		return make64(hi, lo);
+
+	local_irq_save(flags);
+	old = v->counter;
+	v->counter = new;
+	local_irq_restore(flags);
+
+	return old;
+}
+EXPORT_SYMBOL(atomic64_xchg);
+
+void atomic64_set(atomic64_t *v, long long i)
+{
+	atomic64_xchg(v, i);
+}
+EXPORT_SYMBOL(atomic64_set);
+
+long long atomic64_add_return(long long a, atomic64_t *v)
+{
+	unsigned long flags;
+	u32 lo, hi, new_hi;
+	long long new;
+
+	__asm__ __volatile__ (
+"1:	movli.l	@%3, %0		! atomic64_add_return	\n"
+"	mov.l	@%4, %1				\n"
+"	mov	%1, %2				\n"
+"	clrt					\n"
+"	addc	%5, %0				\n"
+"	addc	%6, %2				\n"
+"	cmp/eq	%1, %2				\n"
+"	bf	2f				\n"
+"	movco.l	%0, @%3				\n"
+"	bf	1b				\n"
+"2:						\n"
+	: "=&z" (lo), "=&r" (hi), "=&r" (new_hi)
+	: "r" (atomic64_word(v, LO_WORD)), "r" (atomic64_word(v, HI_WORD)),
+	  "r" ((u32)a), "r" (hi_word(a))
+	: "t", "memory");
+
+	if (likely(hi == new_hi))
+		return make64(hi, lo);
+
+	local_irq_save(flags);
+	new = v->counter + a;
+	v->counter = new;
+	local_irq_restore(flags);
+
+	return new;
+}
+EXPORT_SYMBOL(atomic64_add_return);
+
+void atomic64_add(long long a, atomic64_t *v)
+{
+	atomic64_add_return(a, v);
+}
+EXPORT_SYMBOL(atomic64_add);
+
+long long atomic64_sub_return(long long a, atomic64_t *v)
+{
+	return atomic64_add_return(-a, v);
+}
+EXPORT_SYMBOL(atomic64_sub_return);
+
+void atomic64_sub(long long a, atomic64_t *v)
+{
+	atomic64_add_return(-a, v);
+}
+EXPORT_SYMBOL(atomic64_sub);
+
+long long atomic64_dec_if_positive(atomic64_t *v)
+{
+	unsigned long flags;
+	u32 tmp, lo, hi, new_hi;
+	long long new;
+
+	/* A negative result stores the old value back, just to validate it */
+	__asm__ __volatile__ (
+"1:	movli.l	@%4, %0		! atomic64_dec_if_positive	\n"
+"	mov.l	@%5, %2				\n"
+"	mov	%0, %1				\n"
+"	mov	%2, %3				\n"
+"	clrt					\n"
+"	subc	%6, %0				\n"
+"	subc	%7, %3				\n"
+"	cmp/pz	%3				\n"
+"	bt	3f				\n"
+"	bra	4f				\n"
+"	 mov	%1, %0				\n"
+"3:	cmp/eq	%2, %3				\n"
+"	bf	2f				\n"
+"4:	movco.l	%0, @%4				\n"
+"	bf	1b				\n"
+"2:						\n"
+	: "=&z" (tmp), "=&r" (lo), "=&r" (hi), "=&r" (new_hi)
+	: "r" (atomic64_word(v, LO_WORD)), "r" (atomic64_word(v, HI_WORD)),
+	  "r" (1), "r" (0)
+	: "t", "memory");
+
+	new = make64(hi, lo) - 1;
+	if (likely(new < 0 || hi == new_hi))
+		return new;
+
+	local_irq_save(flags);
+	new = v->counter - 1;
+	if (new >= 0)
+		v->counter = new;
+	local_irq_restore(flags);
+
+	return new;
+}
+EXPORT_SYMBOL(atomic64_dec_if_positive);
+
+long long atomic64_cmpxchg(atomic64_t *v, long long o, long long n)
+{
+	unsigned long flags;
+	u32 tmp, lo, hi;
+	long long old;
+
+	/* A mismatch stores the old value back, just to validate it */
+	__asm__ __volatile__ (
+"1:	movli.l	@%3, %0		! atomic64_cmpxchg	\n"
+"	mov.l	@%4, %2				\n"
+"	mov	%0, %1				\n"
+"	cmp/eq	%1, %5				\n"
+"	bf	3f				\n"
+"	cmp/eq	%2, %6				\n"
+"	bf	3f				\n"
+"	cmp/eq	%2, %8				\n"
+"	bf	2f				\n"
+"	mov	%7, %0				\n"
+"3:	movco.l	%0, @%3				\n"
+"	bf	1b				\n"
+"2:						\n"
+	: "=&z" (tmp), "=&r" (lo), "=&r" (hi)
+	: "r" (atomic64_word(v, LO_WORD)), "r" (atomic64_word(v, HI_WORD)),
+	  "r" ((u32)o), "r" (hi_word(o)), "r" ((u32)n), "r" (hi_word(n))
+	: "t", "memory");
+
+	old = make64(hi, lo);
+	if (likely(old != o || hi == hi_word(n)))
+		return old;
+
+	local_irq_save(flags);
+	old = v->counter;
+	if (old == o)
+		v->counter = n;
+	local_irq_restore(flags);
+
+	return old;
+}
+EXPORT_SYMBOL(atomic64_cmpxchg);
+
+int atomic64_add_unless(atomic64_t *v, long long a, long long u)
+{
+	unsigned long flags;
+	u32 lo, hi, old_lo, new_hi;
+	long long old;
+
+	/* old == u stores the old value back, just to validate it */
+	__asm__ __volatile__ (
+"1:	movli.l	@%4, %0		! atomic64_add_unless	\n"
+"	mov.l	@%5, %2				\n"
+"	mov	%0, %1				\n"
+"	mov	%2, %3				\n"
+"	cmp/eq	%1, %8				\n"
+"	bf	3f				\n"
+"	cmp/eq	%2, %9				\n"
+"	bt	4f				\n"
+"3:	clrt					\n"
+"	addc	%6, %0				\n"
+"	addc	%7, %3				\n"
+"	cmp/eq	%2, %3				\n"
+"	bf	2f				\n"
+"4:	movco.l	%0, @%4				\n"
+"	bf	1b				\n"
+"2:						\n"
+	: "=&z" (lo), "=&r" (old_lo), "=&r" (hi), "=&r" (new_hi)
+	: "r" (atomic64_word(v, LO_WORD)), "r" (atomic64_word(v, HI_WORD)),
+	  "r" ((u32)a), "r" (hi_word(a)), "r" ((u32)u), "r" (hi_word(u))
+	: "t", "memory");
+
+	old = make64(hi, old_lo);
+	if (old == u)
+		return 0;
+	if (likely(hi == new_hi))
+		return 1;
+
+	local_irq_save(flags);
+	old = v->counter;
+	if (old != u)
+		v->counter += a;
+	local_irq_restore(flags);
+
+	return old != u;
+}
+EXPORT_SYMBOL(atomic64_add_unless);
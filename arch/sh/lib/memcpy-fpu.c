@@ -0,0 +1,92 @@
+/*
+ * arch/sh/lib/memcpy-fpu.c - memcpy/__copy_user with an FPU bulk path
+ *
+ * Copies of FPU_COPY_MIN bytes and more whose source and destination
+ * agree modulo 8 have their 32-byte aligned middle moved with fmov.d
+ * pair moves, the head and tail going through the integer routines.
+ * Everything else goes straight to those, as does anything that would
+ * have to save live user FPU state first or runs in interrupt context.
+ *
+ * memcpy() has an FPU loop of its own without exception table entries,
+ * so a fault on a kernel address oopses where it happens instead of
+ * being turned into a short copy.
+ *
+ * User copies run the FPU loop with page faults disabled, as nothing
+ * may sleep while the FPU is claimed. A fault drops back to the integer
+ * copy from the line it happened on, which then takes it properly.
+ *
+ * This file is subject to the terms and conditions of the GNU General Public
+ * License.  See the file "COPYING" in the main directory of this archive
+ * for more details.
+ */
+#include <linux/types.h>
+#include <linux/sched.h>
+#include <linux/hardirq.h>
+#include <linux/uaccess.h>
+#include <asm/processor.h>
+#include <asm/fpu.h>
+
+#define FPU_COPY_MIN	512
+
+extern void *__memcpy_generic(void *to, const void *from, size_t n);
+extern void __memcpy_fpu(void *to, const void *from, size_t n);
+extern __kernel_size_t __copy_user_generic(void *to, const void *from,
+					   __kernel_size_t n);
+extern __kernel_size_t __copy_user_fpu(void *to, const void *from,
+				       __kernel_size_t n);
+
+static inline int fpu_copy_ok(const void *to, const void *from, size_t n)
+{
+	if (n < FPU_COPY_MIN || (((unsigned long)to ^ (unsigned long)from) & 7))
+		return 0;
+
+	return (boot_cpu_data.flags & CPU_HAS_FPU) && !in_interrupt() &&
+	       !(current_thread_info()->status & TS_USEDFPU);
+}
+
+void *memcpy(void *to, const void *from, size_t n)
+{
+	size_t head, body;
+
+	if (!fpu_copy_ok(to, from, n))
+		return __memcpy_generic(to, from, n);
+
+	head = -(unsigned long)to & 31;
+	body = (n - head) & ~31;
+
+	__memcpy_generic(to, from, head);
+
+	kernel_fpu_begin();
+	__memcpy_fpu(to + head, from + head, body);
+	kernel_fpu_end();
+
+	__memcpy_generic(to + head + body, from + head + body,
+			 n - head - body);
+
+	return to;
+}
+
+__kernel_size_t __copy_user(void *to, const void *from, __kernel_size_t n)
+{
+	size_t head, body, left;
+
+	if (!fpu_copy_ok(to, from, n))
+		return __copy_user_generic(to, from, n);
+
+	head = -(unsigned long)to & 31;
+	body = (n - head) & ~31;
+
+	left = __copy_user_generic(to, from, head);
+	if (unlikely(left))
+		return left + n - head;
+
+	pagefault_disable();
+	kernel_fpu_begin();
+	left = __copy_user_fpu(to + head, from + head, body);
+	kernel_fpu_end();
+	pagefault_enable();
+
+	head += body - left;
+
+	return __copy_user_generic(to + head, from + head, n - head);
+}
@@ -0,0 +1,57 @@
+/*
+ * arch/sh/lib/page-sh4a.c - copy_page/clear_page for SH-4A
+ *
+ * Picks between the integer and FPU kernels in copy_page-sh4a.S. The
+ * FPU is only borrowed when that is free: not in interrupt context, and
+ * not while the current task has live FPU state of its own, which would
+ * otherwise have to be saved here and restored through a trap later on.
+ *
+ * This file is subject to the terms and conditions of the GNU General Public
+ * License.  See the file "COPYING" in the main directory of this archive
+ * for more details.
+ */
+#include <linux/module.h>
+#include <linux/sched.h>
+#include <linux/hardirq.h>
+#include <asm/page.h>
+#include <asm/processor.h>
+#include <asm/fpu.h>
+
+static inline int page_fpu_usable(void)
+{
+#ifdef CONFIG_SH_FPU
+	return (boot_cpu_data.flags & CPU_HAS_FPU) && !in_interrupt() &&
+	       !(current_thread_info()->status & TS_USEDFPU);
+#else
+	return 0;
+#endif
+}
+
+void copy_page(void *to, void *from)
+{
+#ifdef CONFIG_SH_FPU
+	if (page_fpu_usable()) {
+		kernel_fpu_begin();
+		__copy_page_sh4a_fpu(to, from);
+		kernel_fpu_end();
+		return;
+	}
+#endif
+
+	__copy_page_sh4a(to, from);
+}
+
+void clear_page(void *to)
+{
+#ifdef CONFIG_SH_FPU
+	if (page_fpu_usable()) {
+		kernel_fpu_begin();
+		__clear_page_sh4a_fpu(to);
+		kernel_fpu_end();
+		return;
+	}
+#endif
+
+	__clear_page_sh4a(to);
+}
+EXPORT_SYMBOL(clear_page);
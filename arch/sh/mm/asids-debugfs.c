@@ -12,6 +12,9 @@
  * link, this shows ASID + PC. To make use of this, the PID->ASID
  * relationship needs to be known. This is primarily for debugging.
  *
+ * A second file, tlb_stats, shows ASID allocation and TLB flush event
+ * counts per CPU. Writing anything to it clears the counters.
+ *
  * This file is subject to the terms and conditions of the GNU General Public
  * License.  See the file "COPYING" in the main directory of this archive
  * for more details.
@@ -23,6 +26,27 @@
 #include <linux/spinlock.h>
 #include <asm/processor.h>
 #include <asm/mmu_context.h>
+#include <asm/tlbflush.h>
+
+unsigned long tlb_stats[NR_CPUS][NR_TLB_STATS];
+
+static const char *tlb_stat_names[NR_TLB_STATS] = {
+	[TLB_STAT_ASID_ALLOC]			= "asid_alloc",
+	[TLB_STAT_ASID_ROLLOVER]		= "asid_rollover",
+	[TLB_STAT_FLUSH_ALL]			= "flush_all",
+	[TLB_STAT_FLUSH_MM]			= "flush_mm",
+	[TLB_STAT_FLUSH_PAGE]			= "flush_page",
+	[TLB_STAT_FLUSH_RANGE]			= "flush_range",
+	[TLB_STAT_FLUSH_RANGE_PAGES]		= "flush_range_pages",
+	[TLB_STAT_FLUSH_RANGE_CONTEXT]		= "flush_range_context",
+	[TLB_STAT_FLUSH_KERNEL_RANGE]		= "flush_kernel_range",
+	[TLB_STAT_FLUSH_KERNEL_RANGE_ALL]	= "flush_kernel_range_all",
+	[TLB_STAT_LOAD_64K]			= "load_64k",
+	[TLB_STAT_LOAD_1M]			= "load_1m",
+	[TLB_STAT_LOAD_WIRED]			= "load_wired",
+	[TLB_STAT_REFILL_FAST]			= "refill_fast",
+	[TLB_STAT_REFILL_SLOW]			= "refill_slow",
+};
 
 static int asids_seq_show(struct seq_file *file, void *iter)
 {
@@ -59,9 +83,51 @@ static const struct file_operations asids_debugfs_fops = {
 	.release	= single_release,
 };
 
+static int tlb_stats_seq_show(struct seq_file *file, void *iter)
+{
+	int cpu, i;
+
+	seq_printf(file, "%-24s", "");
+	for_each_online_cpu(cpu)
+		seq_printf(file, " %10s%-3d", "CPU", cpu);
+	seq_putc(file, '\n');
+
+	for (i = 0; i < NR_TLB_STATS; i++) {
+		seq_printf(file, "%-24s", tlb_stat_names[i]);
+		for_each_online_cpu(cpu)
+			seq_printf(file, " %13lu", tlb_stats[cpu][i]);
+		seq_putc(file, '\n');
+	}
+
+	return 0;
+}
+
+static int tlb_stats_debugfs_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, tlb_stats_seq_show, inode->i_private);
+}
+
+static ssize_t tlb_stats_debugfs_write(struct file *file,
+				       const char __user *buf,
+				       size_t count, loff_t *ppos)
+{
+	memset(tlb_stats, 0, sizeof(tlb_stats));
+
+	return count;
+}
+
+static const struct file_operations tlb_stats_debugfs_fops = {
+	.owner		= THIS_MODULE,
+	.open		= tlb_stats_debugfs_open,
+	.read		= seq_read,
+	.write		= tlb_stats_debugfs_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 static int __init asids_debugfs_init(void)
 {
-	struct dentry *asids_dentry;
+	struct dentry *asids_dentry, *tlb_dentry;
 
 	asids_dentry = debugfs_create_file("asids", S_IRUSR, sh_debugfs_root,
 					   NULL, &asids_debugfs_fops);
@@ -70,6 +136,23 @@ static int __init asids_debugfs_init(void)
 	if (IS_ERR(asids_dentry))
 		return PTR_ERR(asids_dentry);
 
+	tlb_dentry = debugfs_create_file("tlb_stats", S_IRUSR | S_IWUSR,
+					 sh_debugfs_root, NULL,
+					 &tlb_stats_debugfs_fops);
+	if (!tlb_dentry) {
+		debugfs_remove(asids_dentry);
+		return -ENOMEM;
+	}
+	if (IS_ERR(tlb_dentry)) {
+		debugfs_remove(asids_dentry);
+		return PTR_ERR(tlb_dentry);
+	}
+
+#ifdef CONFIG_TLB_FAST_REFILL
+	debugfs_create_bool("tlb_fast_refill", S_IRUSR | S_IWUSR,
+			    sh_debugfs_root, &tlb_fast_refill);
+#endif
+
 	return 0;
 }
 module_init(asids_debugfs_init);
@@ -3,6 +3,12 @@
  *
  *  Copyright (C) 2006  Paul Mundt
  *
+ * The dcache_stats file counts what happened to D-cache alias flushes
+ * requested through flush_dcache_page(): flushed right away, deferred
+ * until the page is mapped, and then either performed or reduced to a
+ * write-back because the user mapping has the kernel's colour.
+ * Writing anything to it clears the counters.
+ *
  * This file is subject to the terms and conditions of the GNU General Public
  * License.  See the file "COPYING" in the main directory of this archive
  * for more details.
@@ -15,6 +21,16 @@
 #include <asm/uaccess.h>
 #include <asm/cache.h>
 #include <asm/io.h>
+#include <asm/cacheflush.h>
+
+unsigned long dcache_stats[NR_CPUS][NR_DCACHE_STATS];
+
+static const char *dcache_stat_names[NR_DCACHE_STATS] = {
+	[DCACHE_STAT_FLUSH_EAGER]		= "flush_eager",
+	[DCACHE_STAT_FLUSH_DEFERRED]		= "flush_deferred",
+	[DCACHE_STAT_FLUSH_LAZY]		= "flush_lazy",
+	[DCACHE_STAT_FLUSH_AVOIDED]		= "flush_avoided",
+};
 
 enum cache_type {
 	CACHE_TYPE_ICACHE,
@@ -122,9 +138,51 @@ static const struct file_operations cache_debugfs_fops = {
 	.release	= single_release,
 };
 
+static int dcache_stats_seq_show(struct seq_file *file, void *iter)
+{
+	int cpu, i;
+
+	seq_printf(file, "%-24s", "");
+	for_each_online_cpu(cpu)
+		seq_printf(file, " %10s%-3d", "CPU", cpu);
+	seq_putc(file, '\n');
+
+	for (i = 0; i < NR_DCACHE_STATS; i++) {
+		seq_printf(file, "%-24s", dcache_stat_names[i]);
+		for_each_online_cpu(cpu)
+			seq_printf(file, " %13lu", dcache_stats[cpu][i]);
+		seq_putc(file, '\n');
+	}
+
+	return 0;
+}
+
+static int dcache_stats_debugfs_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, dcache_stats_seq_show, inode->i_private);
+}
+
+static ssize_t dcache_stats_debugfs_write(struct file *file,
+					  const char __user *buf,
+					  size_t count, loff_t *ppos)
+{
+	memset(dcache_stats, 0, sizeof(dcache_stats));
+
+	return count;
+}
+
+static const struct file_operations dcache_stats_debugfs_fops = {
+	.owner		= THIS_MODULE,
+	.open		= dcache_stats_debugfs_open,
+	.read		= seq_read,
+	.write		= dcache_stats_debugfs_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 static int __init cache_debugfs_init(void)
 {
-	struct dentry *dcache_dentry, *icache_dentry;
+	struct dentry *dcache_dentry, *icache_dentry, *stats_dentry;
 
 	dcache_dentry = debugfs_create_file("dcache", S_IRUSR, sh_debugfs_root,
 					    (unsigned int *)CACHE_TYPE_DCACHE,
@@ -146,6 +204,15 @@ static int __init cache_debugfs_init(void)
 		return PTR_ERR(icache_dentry);
 	}
 
+	stats_dentry = debugfs_create_file("dcache_stats", S_IRUSR | S_IWUSR,
+					   sh_debugfs_root, NULL,
+					   &dcache_stats_debugfs_fops);
+	if (!stats_dentry || IS_ERR(stats_dentry)) {
+		debugfs_remove(icache_dentry);
+		debugfs_remove(dcache_dentry);
+		return stats_dentry ? PTR_ERR(stats_dentry) : -ENOMEM;
+	}
+
 	return 0;
 }
 module_init(cache_debugfs_init);
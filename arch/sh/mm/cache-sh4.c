@@ -105,20 +105,29 @@ static inline void flush_cache_one(unsigned long start, unsigned long phys)
 /*
  * Write back & invalidate the D-cache of the page.
  * (To avoid "alias" issues)
+ *
+ * As long as nothing in userspace maps a page cache page there is no
+ * alias to worry about yet, so just mark it and leave the flush to
+ * __update_cache() once the page is mapped. That also gets to see the
+ * user address, and only writes the page back when the colours match.
+ * Anonymous pages are always flushed here.
  */
 static void sh4_flush_dcache_page(void *arg)
 {
 	struct page *page = arg;
 	unsigned long addr = (unsigned long)page_address(page);
-#ifndef CONFIG_SMP
-	struct address_space *mapping = page_mapping(page);
 
-	if (mapping && !mapping_mapped(mapping))
+#ifndef CONFIG_SMP
+	if (page_mapping(page) && !page_mapped(page)) {
 		set_bit(PG_dcache_dirty, &page->flags);
-	else
+		dcache_stat_inc(smp_processor_id(), DCACHE_STAT_FLUSH_DEFERRED);
+	} else
 #endif
+	{
 		flush_cache_one(CACHE_OC_ADDRESS_ARRAY |
 				(addr & shm_align_mask), page_to_phys(page));
+		dcache_stat_inc(smp_processor_id(), DCACHE_STAT_FLUSH_EAGER);
+	}
 
 	wmb();
 }
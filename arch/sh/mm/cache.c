@@ -140,10 +140,26 @@ void __update_cache(struct vm_area_struct *vma,
 		return;
 
 	page = pfn_to_page(pfn);
-	if (pfn_valid(pfn)) {
-		int dirty = test_and_clear_bit(PG_dcache_dirty, &page->flags);
-		if (dirty)
-			__flush_purge_region(page_address(page), PAGE_SIZE);
+	if (pfn_valid(pfn) &&
+	    test_and_clear_bit(PG_dcache_dirty, &page->flags)) {
+		void *kaddr = page_address(page);
+
+		/*
+		 * If the user mapping has the same colour as the kernel
+		 * one, the dirty lines are already where userspace will
+		 * look for them, and only have to reach memory: for the
+		 * I-cache, which fills from memory, and for any later
+		 * mapping of a different colour.
+		 */
+		if (pages_do_alias((unsigned long)kaddr, address & PAGE_MASK)) {
+			__flush_purge_region(kaddr, PAGE_SIZE);
+			dcache_stat_inc(smp_processor_id(),
+					DCACHE_STAT_FLUSH_LAZY);
+		} else {
+			__flush_wback_region(kaddr, PAGE_SIZE);
+			dcache_stat_inc(smp_processor_id(),
+					DCACHE_STAT_FLUSH_AVOIDED);
+		}
 	}
 }
 
@@ -318,6 +318,14 @@ do_sigbus:
 		goto no_context;
 }
 
+#ifdef CONFIG_TLB_FAST_REFILL
+/*
+ * Lets the assembly refill path in entry.S be switched off at run time
+ * through debugfs, for comparing the two.
+ */
+u32 tlb_fast_refill = 1;
+#endif
+
 /*
  * Called with interrupts disabled.
  */
@@ -376,5 +384,7 @@ handle_tlbmiss(struct pt_regs *regs, unsigned long writeaccess,
 
 	update_mmu_cache(NULL, address, entry);
 
+	tlb_stat_inc(smp_processor_id(), TLB_STAT_REFILL_SLOW);
+
 	return 0;
 }
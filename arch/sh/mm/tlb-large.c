@@ -0,0 +1,144 @@
+/*
+ * arch/sh/mm/tlb-large.c
+ *
+ * Transparent 64kB/1MB TLB entries for user mappings.
+ *
+ * The SH-4 UTLB has 64 entries, which a couple of video frames mapped
+ * with 4kB pages will happily thrash. Whenever a user TLB entry is
+ * loaded, check whether the naturally aligned 64kB or 1MB block around
+ * the address is mapped by physically contiguous ptes that are
+ * identical in every other respect. If so, a single entry of that size
+ * is loaded instead. The page tables themselves are left alone.
+ *
+ * This is safe as long as every pte change is followed by a TLB flush
+ * of that page, which the core mm already guarantees: the associative
+ * address array write used to flush a page hits any entry covering it,
+ * whatever its size. Ptes only ever become present without a flush, but
+ * then the block was not fully populated and no large entry exists.
+ *
+ * This file is subject to the terms and conditions of the GNU General Public
+ * License.  See the file "COPYING" in the main directory of this archive
+ * for more details.
+ */
+#include <linux/kernel.h>
+#include <linux/mm.h>
+#include <linux/sched.h>
+#include <asm/pgtable.h>
+#include <asm/mmu_context.h>
+#include <asm/tlbflush.h>
+
+#ifdef CONFIG_X2TLB
+#define TLB_SZ_MASK	_PAGE_EXT(_PAGE_EXT_ESZ0 | _PAGE_EXT_ESZ1 | \
+				  _PAGE_EXT_ESZ2 | _PAGE_EXT_ESZ3)
+#define TLB_SZ_64K	_PAGE_EXT(_PAGE_EXT_ESZ2)
+#define TLB_SZ_1M	_PAGE_EXT(_PAGE_EXT_ESZ0 | _PAGE_EXT_ESZ1 | \
+				  _PAGE_EXT_ESZ2)
+#else
+#define TLB_SZ_MASK	_PAGE_SZ_MASK
+#define TLB_SZ_64K	_PAGE_SZ1
+#define TLB_SZ_1M	(_PAGE_SZ0 | _PAGE_SZ1)
+#endif
+
+static const struct {
+	unsigned long size;
+	unsigned long long bits;
+	int stat;
+} tlb_large_sizes[] = {
+#ifndef CONFIG_PAGE_SIZE_64KB
+	{ 0x10000,	TLB_SZ_64K,	TLB_STAT_LOAD_64K },
+#endif
+	{ 0x100000,	TLB_SZ_1M,	TLB_STAT_LOAD_1M },
+};
+
+/*
+ * Check that the @nr ptes from @ptep on map consecutive pages with the
+ * same attributes as @base. The last one is looked at first, as that
+ * is what usually differs when the block is only partially mapped.
+ */
+static int tlb_large_block(pte_t *ptep, pte_t base, unsigned int nr)
+{
+	unsigned long long val = pte_val(base);
+	unsigned int i;
+
+	if (pte_val(ptep[nr - 1]) !=
+	    val + ((unsigned long long)(nr - 1) << PAGE_SHIFT))
+		return 0;
+
+	for (i = 0; i < nr - 1; i++, val += PAGE_SIZE)
+		if (pte_val(ptep[i]) != val)
+			return 0;
+
+	return 1;
+}
+
+/*
+ * Called by __update_tlb() with interrupts disabled. Returns the pte to
+ * load, and aligns *address down to the start of the block when a large
+ * entry is used. Any smaller entries for the block are flushed first,
+ * as a multiple hit in the UTLB is fatal. Only the entries actually in
+ * the TLB are looked for: a 1MB block is 256 pages, the TLB 68 entries.
+ */
+pte_t tlb_large_pte(unsigned long *address, pte_t pte)
+{
+	struct mm_struct *mm = current->active_mm;
+	unsigned long addr = *address;
+	unsigned long start;
+	pgd_t *pgd;
+	pud_t *pud;
+	pmd_t *pmd;
+	pte_t *ptep, base;
+	int i, found = -1;
+
+	if (addr >= TASK_SIZE || !mm)
+		return pte;
+
+	/* Leave hugetlb and wired entries as they are */
+	if ((pte_val(pte) & TLB_SZ_MASK) != _PAGE_FLAGS_HARD ||
+	    (pte_val(pte) & _PAGE_WIRED))
+		return pte;
+
+	pgd = pgd_offset(mm, addr);
+	if (pgd_none(*pgd) || pgd_bad(*pgd))
+		return pte;
+	pud = pud_offset(pgd, addr);
+	if (pud_none(*pud) || pud_bad(*pud))
+		return pte;
+	pmd = pmd_offset(pud, addr);
+	if (pmd_none(*pmd) || pmd_bad(*pmd))
+		return pte;
+	ptep = pte_offset_kernel(pmd, addr);
+
+	for (i = 0; i < ARRAY_SIZE(tlb_large_sizes); i++) {
+		unsigned long size = tlb_large_sizes[i].size;
+		unsigned int nr = size >> PAGE_SHIFT;
+		unsigned int idx = (addr & (size - 1)) >> PAGE_SHIFT;
+
+		/*
+		 * The block has to be physically aligned, too. Checked on
+		 * the full pte, so that computing the base can't borrow
+		 * into the upper word of an X2TLB pte.
+		 */
+		if (((pte_val(pte) >> PAGE_SHIFT) & (nr - 1)) != idx)
+			break;
+
+		base = __pte(pte_val(pte) -
+			     ((unsigned long long)idx << PAGE_SHIFT));
+		if (!tlb_large_block(ptep - idx, base, nr))
+			break;
+
+		found = i;
+	}
+
+	if (found < 0)
+		return pte;
+
+	start = addr & ~(tlb_large_sizes[found].size - 1);
+	local_flush_tlb_scan(get_asid(), start,
+			     start + tlb_large_sizes[found].size);
+	tlb_stat_inc(smp_processor_id(), tlb_large_sizes[found].stat);
+
+	*address = start;
+
+	return __pte(((pte_val(pte) - ((addr - start) & PAGE_MASK)) &
+		      ~TLB_SZ_MASK) | tlb_large_sizes[found].bits);
+}
@@ -15,18 +15,15 @@
 #include <asm/system.h>
 #include <asm/mmu_context.h>
 #include <asm/cacheflush.h>
+#include <asm/tlb.h>
 
-void __update_tlb(struct vm_area_struct *vma, unsigned long address, pte_t pte)
+/*
+ * Load @pte for @address into the UTLB entry MMUCR.URC points at.
+ * Must be called with interrupts disabled.
+ */
+void tlb_load_entry(unsigned long address, pte_t pte)
 {
-	unsigned long flags, pteval, vpn;
-
-	/*
-	 * Handle debugger faulting in for debugee.
-	 */
-	if (vma && current->active_mm != vma->vm_mm)
-		return;
-
-	local_irq_save(flags);
+	unsigned long pteval, vpn;
 
 	/* Set PTEH register */
 	vpn = address & MMU_VPN_MASK;
@@ -58,6 +55,26 @@ void __update_tlb(struct vm_area_struct *vma, unsigned long address, pte_t pte)
 
 	/* Load the TLB */
 	asm volatile("ldtlb": /* no output */ : /* no input */ : "memory");
+}
+
+void __update_tlb(struct vm_area_struct *vma, unsigned long address, pte_t pte)
+{
+	unsigned long flags;
+
+	/*
+	 * Handle debugger faulting in for debugee.
+	 */
+	if (vma && current->active_mm != vma->vm_mm)
+		return;
+
+	local_irq_save(flags);
+
+	if (!tlb_wired_update(address, pte)) {
+		/* Use a 64kB/1MB entry if the surrounding block allows it */
+		pte = tlb_large_pte(&address, pte);
+		tlb_load_entry(address, pte);
+	}
+
 	local_irq_restore(flags);
 }
 
@@ -75,3 +92,47 @@ void local_flush_tlb_one(unsigned long asid, unsigned long page)
 	__raw_writel(asid, MMU_UTLB_ADDRESS_ARRAY2 | MMU_PAGE_ASSOC_BIT);
 	back_to_cached();
 }
+
+void local_flush_tlb_pages(unsigned long asid, unsigned long start,
+			   unsigned long end)
+{
+	jump_to_uncached();
+	for (; start < end; start += PAGE_SIZE) {
+		__raw_writel(start, MMU_UTLB_ADDRESS_ARRAY | MMU_PAGE_ASSOC_BIT);
+		__raw_writel(asid, MMU_UTLB_ADDRESS_ARRAY2 | MMU_PAGE_ASSOC_BIT);
+	}
+	back_to_cached();
+}
+
+static inline int tlb_scan_match(unsigned long data, unsigned long start,
+				 unsigned long end)
+{
+	unsigned long vpn = data & MMU_VPN_MASK;
+
+	return (data & MMU_TLB_VALID) && vpn >= start && vpn < end;
+}
+
+/*
+ * As the tlb-sh4.c version, but the ASID lives in the second address
+ * array here. Entries in the range are dropped whatever their ASID,
+ * which at worst costs another context a refill.
+ */
+void local_flush_tlb_scan(unsigned long asid, unsigned long start,
+			  unsigned long end)
+{
+	unsigned long addr;
+	int i;
+
+	jump_to_uncached();
+	for (i = 0; i < MMU_NTLB_ENTRIES; i++) {
+		addr = MMU_UTLB_ADDRESS_ARRAY | (i << MMU_TLB_ENTRY_SHIFT);
+		if (tlb_scan_match(__raw_readl(addr), start, end))
+			__raw_writel(0, addr);
+	}
+	for (i = 0; i < MMU_NITLB_ENTRIES; i++) {
+		addr = MMU_ITLB_ADDRESS_ARRAY | (i << MMU_TLB_ENTRY_SHIFT);
+		if (tlb_scan_match(__raw_readl(addr), start, end))
+			__raw_writel(0, addr);
+	}
+	back_to_cached();
+}
@@ -77,3 +77,10 @@ void local_flush_tlb_one(unsigned long asid, unsigned long page)
 	for (i = 0; i < ways; i++)
 		__raw_writel(data, addr + (i << 8));
 }
+
+void local_flush_tlb_pages(unsigned long asid, unsigned long start,
+			   unsigned long end)
+{
+	for (; start < end; start += PAGE_SIZE)
+		local_flush_tlb_one(asid, start);
+}
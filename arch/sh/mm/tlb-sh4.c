@@ -14,18 +14,15 @@
 #include <asm/system.h>
 #include <asm/mmu_context.h>
 #include <asm/cacheflush.h>
+#include <asm/tlb.h>
 
-void __update_tlb(struct vm_area_struct *vma, unsigned long address, pte_t pte)
+/*
+ * Load @pte for @address into the UTLB entry MMUCR.URC points at.
+ * Must be called with interrupts disabled.
+ */
+void tlb_load_entry(unsigned long address, pte_t pte)
 {
-	unsigned long flags, pteval, vpn;
-
-	/*
-	 * Handle debugger faulting in for debugee.
-	 */
-	if (vma && current->active_mm != vma->vm_mm)
-		return;
-
-	local_irq_save(flags);
+	unsigned long pteval, vpn;
 
 	/* Set PTEH register */
 	vpn = (address & MMU_VPN_MASK) | get_asid();
@@ -61,6 +58,26 @@ void __update_tlb(struct vm_area_struct *vma, unsigned long address, pte_t pte)
 
 	/* Load the TLB */
 	asm volatile("ldtlb": /* no output */ : /* no input */ : "memory");
+}
+
+void __update_tlb(struct vm_area_struct *vma, unsigned long address, pte_t pte)
+{
+	unsigned long flags;
+
+	/*
+	 * Handle debugger faulting in for debugee.
+	 */
+	if (vma && current->active_mm != vma->vm_mm)
+		return;
+
+	local_irq_save(flags);
+
+	if (!tlb_wired_update(address, pte)) {
+		/* Use a 64kB/1MB entry if the surrounding block allows it */
+		pte = tlb_large_pte(&address, pte);
+		tlb_load_entry(address, pte);
+	}
+
 	local_irq_restore(flags);
 }
 
@@ -80,3 +97,55 @@ void local_flush_tlb_one(unsigned long asid, unsigned long page)
 	__raw_writel(data, addr);
 	back_to_cached();
 }
+
+/*
+ * As above, for every page in [start, end). The associative write also
+ * invalidates a matching ITLB entry, so a single trip through P2 is
+ * enough for the whole batch.
+ */
+void local_flush_tlb_pages(unsigned long asid, unsigned long start,
+			   unsigned long end)
+{
+	unsigned long addr = MMU_UTLB_ADDRESS_ARRAY | MMU_PAGE_ASSOC_BIT;
+
+	jump_to_uncached();
+	for (; start < end; start += PAGE_SIZE)
+		__raw_writel(start | asid, addr);
+	back_to_cached();
+}
+
+static inline int tlb_scan_match(unsigned long data, unsigned long asid,
+				 unsigned long start, unsigned long end)
+{
+	unsigned long vpn = data & MMU_VPN_MASK;
+
+	return (data & MMU_TLB_VALID) &&
+	       (data & MMU_CONTEXT_ASID_MASK) == asid &&
+	       vpn >= start && vpn < end;
+}
+
+/*
+ * Invalidate the UTLB and ITLB entries of @asid that lie in [start, end)
+ * by reading through the address arrays. That is one read per TLB entry
+ * rather than one write per page, which wins for ranges much bigger than
+ * the TLB, and only the entries that are actually loaded get written.
+ */
+void local_flush_tlb_scan(unsigned long asid, unsigned long start,
+			  unsigned long end)
+{
+	unsigned long addr;
+	int i;
+
+	jump_to_uncached();
+	for (i = 0; i < MMU_NTLB_ENTRIES; i++) {
+		addr = MMU_UTLB_ADDRESS_ARRAY | (i << MMU_TLB_ENTRY_SHIFT);
+		if (tlb_scan_match(__raw_readl(addr), asid, start, end))
+			__raw_writel(0, addr);
+	}
+	for (i = 0; i < MMU_NITLB_ENTRIES; i++) {
+		addr = MMU_ITLB_ADDRESS_ARRAY | (i << MMU_TLB_ENTRY_SHIFT);
+		if (tlb_scan_match(__raw_readl(addr), asid, start, end))
+			__raw_writel(0, addr);
+	}
+	back_to_cached();
+}
@@ -9,39 +9,194 @@
  * License.  See the file "COPYING" in the main directory of this archive
  * for more details.
  */
+#include <linux/init.h>
 #include <linux/mm.h>
 #include <linux/io.h>
+#include <linux/sched.h>
+#include <linux/mutex.h>
+#include <linux/module.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/uaccess.h>
 #include <asm/tlb.h>
 #include <asm/mmu_context.h>
+#include <asm/system.h>
+
+/*
+ * The UTLB entries from MMUCR.URB up are skipped by the replacement
+ * counter, so wired entries stack downwards from the last UTLB entry:
+ * slot n lives in UTLB entry MMUCR_URB_NENTRIES - 1 - n.
+ *
+ * A slot only records which page it is for. The entry itself is loaded
+ * by __update_tlb() whenever that page misses, so a slot that loses its
+ * entry to a flush of the page or of the whole TLB simply gets it back
+ * on the next access. User slots are matched on the mm rather than the
+ * ASID, and an mm that gets a new ASID leaves behind an entry that can't
+ * match anything until the ASIDs roll over, which flushes everything.
+ */
+#define TLB_WIRED_MAX		(MMUCR_URB_NENTRIES - 1)
+
+/* How many slots tlb_wire_range() may take in total */
+#define TLB_WIRED_RANGE_MAX	(MMUCR_URB_NENTRIES / 4)
+
+#define TLB_WIRED_ENTRY		0x1	/* from tlb_wire_entry() */
+
+struct tlb_wired {
+	unsigned long		addr;
+	struct mm_struct	*mm;
+	unsigned int		flags;
+	unsigned long		loads;
+};
+
+static struct tlb_wired tlb_wired[TLB_WIRED_MAX];
+unsigned int tlb_nr_wired;
+
+/* Serializes tlb_wire_range() and friends */
+static DEFINE_MUTEX(tlb_wired_mutex);
+static unsigned int tlb_nr_wired_range;
+
+static inline unsigned long tlb_wired_index(int slot)
+{
+	return MMUCR_URB_NENTRIES - 1 - slot;
+}
+
+static void tlb_wired_set_urb(void)
+{
+	unsigned long status;
+
+	status = __raw_readl(MMUCR);
+	status &= ~(MMUCR_URB | MMUCR_URC | MMUCR_TI);
+
+	/* An URB of 0 leaves all entries to the replacement counter */
+	status |= ((MMUCR_URB_NENTRIES - tlb_nr_wired) % MMUCR_URB_NENTRIES)
+			<< MMUCR_URB_SHIFT;
+
+	__raw_writel(status, MMUCR);
+	ctrl_barrier();
+}
+
+static void tlb_wired_invalidate(int slot)
+{
+	jump_to_uncached();
+	__raw_writel(0, MMU_UTLB_ADDRESS_ARRAY | (tlb_wired_index(slot) << 8));
+	back_to_cached();
+}
+
+/*
+ * Load @pte into @slot by pointing the replacement counter at it for
+ * the ldtlb. Any copy of the page elsewhere in the UTLB is flushed first,
+ * a multiple hit would be fatal.
+ */
+static void tlb_wired_load(int slot, unsigned long addr, pte_t pte)
+{
+	unsigned long status;
+
+	local_flush_tlb_one(get_asid(), addr);
+
+	status = __raw_readl(MMUCR) & ~MMUCR_TI;
+	__raw_writel((status & ~MMUCR_URC) |
+		     (tlb_wired_index(slot) << MMUCR_URC_SHIFT), MMUCR);
+	ctrl_barrier();
+
+	tlb_load_entry(addr, pte);
+
+	__raw_writel(status, MMUCR);
+	ctrl_barrier();
+
+	tlb_wired[slot].loads++;
+}
+
+static int tlb_wired_find(struct mm_struct *mm, unsigned long addr)
+{
+	int i;
+
+	for (i = 0; i < tlb_nr_wired; i++)
+		if (tlb_wired[i].addr == addr && tlb_wired[i].mm == mm)
+			return i;
+
+	return -1;
+}
+
+static int tlb_wired_add(struct mm_struct *mm, unsigned long addr,
+			 unsigned int flags)
+{
+	struct tlb_wired *w;
+
+	if (tlb_nr_wired == TLB_WIRED_MAX)
+		return -ENOSPC;
+
+	w = &tlb_wired[tlb_nr_wired];
+	w->addr = addr;
+	w->mm = mm;
+	w->flags = flags;
+	w->loads = 0;
+
+	/* Evict whatever the replacement counter left there */
+	tlb_wired_invalidate(tlb_nr_wired);
+
+	tlb_nr_wired++;
+	tlb_wired_set_urb();
+
+	return tlb_nr_wired - 1;
+}
+
+/*
+ * The slots above @slot move down by one. Their entries are dropped
+ * and get reloaded into the new slots on the next miss.
+ */
+static void tlb_wired_remove(int slot)
+{
+	int i;
+
+	for (i = slot; i < tlb_nr_wired; i++)
+		tlb_wired_invalidate(i);
+
+	memmove(&tlb_wired[slot], &tlb_wired[slot + 1],
+		(tlb_nr_wired - slot - 1) * sizeof(struct tlb_wired));
+
+	tlb_nr_wired--;
+	tlb_wired_set_urb();
+}
+
+int __tlb_wired_update(unsigned long address, pte_t pte)
+{
+	struct mm_struct *mm = NULL;
+	int slot;
+
+	if (address < TASK_SIZE)
+		mm = current->active_mm;
+
+	address &= PAGE_MASK;
+
+	slot = tlb_wired_find(mm, address);
+	if (slot < 0)
+		return 0;
+
+	tlb_wired_load(slot, address, pte);
+	tlb_stat_inc(smp_processor_id(), TLB_STAT_LOAD_WIRED);
+
+	return 1;
+}
 
 /*
  * Load the entry for 'addr' into the TLB and wire the entry.
  */
 void tlb_wire_entry(struct vm_area_struct *vma, unsigned long addr, pte_t pte)
 {
-	unsigned long status, flags;
-	int urb;
+	unsigned long flags;
+	int slot;
 
 	local_irq_save(flags);
 
-	/* Load the entry into the TLB */
-	__update_tlb(vma, addr, pte);
-
-	/* ... and wire it up. */
-	status = __raw_readl(MMUCR);
-	urb = (status & MMUCR_URB) >> MMUCR_URB_SHIFT;
-	status &= ~MMUCR_URB;
+	addr &= PAGE_MASK;
 
 	/*
 	 * Make sure we're not trying to wire the last TLB entry slot.
 	 */
-	BUG_ON(!--urb);
+	slot = tlb_wired_add(NULL, addr, TLB_WIRED_ENTRY);
+	BUG_ON(slot < 0);
 
-	urb = urb % MMUCR_URB_NENTRIES;
-
-	status |= (urb << MMUCR_URB_SHIFT);
-	__raw_writel(status, MMUCR);
-	ctrl_barrier();
+	tlb_wired_load(slot, addr, pte);
 
 	local_irq_restore(flags);
 }
@@ -56,26 +211,312 @@ void tlb_wire_entry(struct vm_area_struct *vma, unsigned long addr, pte_t pte)
  */
 void tlb_unwire_entry(void)
 {
-	unsigned long status, flags;
-	int urb;
+	unsigned long flags;
+	int slot;
 
 	local_irq_save(flags);
 
-	status = __raw_readl(MMUCR);
-	urb = (status & MMUCR_URB) >> MMUCR_URB_SHIFT;
-	status &= ~MMUCR_URB;
+	for (slot = tlb_nr_wired - 1; slot >= 0; slot--)
+		if (tlb_wired[slot].flags & TLB_WIRED_ENTRY)
+			break;
 
 	/*
 	 * Make sure we're not trying to unwire a TLB entry when none
 	 * have been wired.
 	 */
-	BUG_ON(urb++ == MMUCR_URB_NENTRIES);
+	BUG_ON(slot < 0);
 
-	urb = urb % MMUCR_URB_NENTRIES;
+	tlb_wired_remove(slot);
 
-	status |= (urb << MMUCR_URB_SHIFT);
-	__raw_writel(status, MMUCR);
-	ctrl_barrier();
+	local_irq_restore(flags);
+}
+
+/*
+ * Drop the page from the TLB so that its next access loads the slot.
+ */
+static void tlb_wired_flush(struct mm_struct *mm, unsigned long addr)
+{
+	unsigned int cpu = smp_processor_id();
+	unsigned long saved_asid;
+
+	if (!mm) {
+		local_flush_tlb_one(get_asid(), addr);
+		return;
+	}
 
+	if (cpu_context(cpu, mm) == NO_CONTEXT)
+		return;
+
+	saved_asid = get_asid();
+	set_asid(cpu_asid(cpu, mm));
+	local_flush_tlb_one(cpu_asid(cpu, mm), addr);
+	set_asid(saved_asid);
+}
+
+/*
+ * Drop the tlb_wire_range() slots of @mm in [start, end).
+ */
+static void tlb_wired_remove_range(struct mm_struct *mm, unsigned long start,
+				   unsigned long end)
+{
+	int slot;
+
+	for (slot = tlb_nr_wired - 1; slot >= 0; slot--) {
+		struct tlb_wired *w = &tlb_wired[slot];
+
+		if (w->flags & TLB_WIRED_ENTRY)
+			continue;
+		if (w->mm != mm || w->addr < start || w->addr >= end)
+			continue;
+
+		tlb_wired_remove(slot);
+		tlb_nr_wired_range--;
+	}
+}
+
+/**
+ * tlb_wire_range - keep a range of pages in the UTLB
+ * @mm: the user mm the range belongs to, or NULL for a kernel range
+ * @start: start address of the range
+ * @size: size of the range in bytes
+ *
+ * Reserves a wired UTLB entry for every page in the range, so that
+ * accesses to it never miss once the entries have been loaded. Kernel
+ * ranges have to be in P3, and user ranges have to be mapped. At most
+ * TLB_WIRED_RANGE_MAX pages can be wired this way.
+ *
+ * The caller has to hold a reference to @mm, see get_task_mm(). The
+ * slots of a user range go away with the mm at the latest, in
+ * tlb_wired_exit_mmap().
+ */
+int tlb_wire_range(struct mm_struct *mm, unsigned long start,
+		   unsigned long size)
+{
+	unsigned long addr, end, flags;
+	unsigned int pages = 0;
+	int ret = 0;
+
+	end = PAGE_ALIGN(start + size);
+	start &= PAGE_MASK;
+
+	if (end <= start)
+		return -EINVAL;
+
+	/*
+	 * MMUCR.URB is per CPU, and nothing here keeps the other CPUs'
+	 * wired entries in sync.
+	 */
+	if (num_possible_cpus() > 1)
+		return -ENODEV;
+
+	if (mm) {
+		if (end > TASK_SIZE)
+			return -EINVAL;
+
+		down_read(&mm->mmap_sem);
+		for (addr = start; addr < end; addr += PAGE_SIZE) {
+			struct vm_area_struct *vma = find_vma(mm, addr);
+
+			if (!vma || vma->vm_start > addr) {
+				ret = -EFAULT;
+				break;
+			}
+		}
+		up_read(&mm->mmap_sem);
+
+		if (ret)
+			return ret;
+	} else if (start < P3SEG || end > P3_ADDR_MAX)
+		return -EINVAL;
+
+	mutex_lock(&tlb_wired_mutex);
+	local_irq_save(flags);
+
+	for (addr = start; addr < end; addr += PAGE_SIZE)
+		if (tlb_wired_find(mm, addr) < 0)
+			pages++;
+
+	if (tlb_nr_wired_range + pages > TLB_WIRED_RANGE_MAX ||
+	    tlb_nr_wired + pages > TLB_WIRED_MAX) {
+		ret = -ENOSPC;
+		goto out;
+	}
+
+	for (addr = start; addr < end; addr += PAGE_SIZE) {
+		if (tlb_wired_find(mm, addr) >= 0)
+			continue;
+
+		tlb_wired_add(mm, addr, 0);
+		tlb_nr_wired_range++;
+
+		tlb_wired_flush(mm, addr);
+	}
+
+out:
+	local_irq_restore(flags);
+	mutex_unlock(&tlb_wired_mutex);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(tlb_wire_range);
+
+/**
+ * tlb_unwire_range - release pages wired by tlb_wire_range()
+ * @mm: the user mm the range belongs to, or NULL for a kernel range
+ * @start: start address of the range
+ * @size: size of the range in bytes
+ */
+void tlb_unwire_range(struct mm_struct *mm, unsigned long start,
+		      unsigned long size)
+{
+	unsigned long flags;
+
+	mutex_lock(&tlb_wired_mutex);
+	local_irq_save(flags);
+	tlb_wired_remove_range(mm, start & PAGE_MASK, PAGE_ALIGN(start + size));
+	local_irq_restore(flags);
+	mutex_unlock(&tlb_wired_mutex);
+}
+EXPORT_SYMBOL_GPL(tlb_unwire_range);
+
+/*
+ * Called from exit_mmap() through arch_exit_mmap(), drops whatever the
+ * dying mm still has wired, so that its slots are free again and the
+ * refill path stops looking at them once nothing else is wired.
+ */
+void tlb_wired_exit_mmap(struct mm_struct *mm)
+{
+	unsigned long flags;
+
+	if (likely(!tlb_nr_wired_range))
+		return;
+
+	mutex_lock(&tlb_wired_mutex);
+	local_irq_save(flags);
+	tlb_wired_remove_range(mm, 0, TASK_SIZE);
 	local_irq_restore(flags);
+	mutex_unlock(&tlb_wired_mutex);
+}
+
+#ifdef CONFIG_DEBUG_FS
+/*
+ * Reading tlb_wired lists the wired slots. Writing one of
+ *
+ *	wire <addr> <size> [pid]
+ *	unwire <addr> <size> [pid]
+ *
+ * wires or unwires a range in the given process, or in the kernel if no
+ * pid is given.
+ */
+static int tlb_wired_seq_show(struct seq_file *file, void *iter)
+{
+	unsigned long flags;
+	int slot;
+
+	mutex_lock(&tlb_wired_mutex);
+
+	seq_printf(file, "slot entry address    owner      loads\n");
+
+	for (slot = 0; slot < tlb_nr_wired; slot++) {
+		struct tlb_wired w;
+
+		local_irq_save(flags);
+		w = tlb_wired[slot];
+		local_irq_restore(flags);
+
+		seq_printf(file, "%4d %5lu 0x%08lx ", slot,
+			   tlb_wired_index(slot), w.addr);
+		if (w.flags & TLB_WIRED_ENTRY)
+			seq_printf(file, "%-10s", "fixmap");
+		else if (w.mm)
+			seq_printf(file, "%p", w.mm);
+		else
+			seq_printf(file, "%-10s", "kernel");
+		seq_printf(file, " %lu\n", w.loads);
+	}
+
+	mutex_unlock(&tlb_wired_mutex);
+
+	return 0;
+}
+
+static int tlb_wired_debugfs_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, tlb_wired_seq_show, inode->i_private);
+}
+
+static ssize_t tlb_wired_debugfs_write(struct file *file,
+				       const char __user *buf,
+				       size_t count, loff_t *ppos)
+{
+	struct task_struct *task;
+	struct mm_struct *mm = NULL;
+	unsigned long addr, size;
+	char cmd[64], op[8];
+	int pid = 0, ret;
+
+	if (count >= sizeof(cmd))
+		return -EINVAL;
+	if (copy_from_user(cmd, buf, count))
+		return -EFAULT;
+	cmd[count] = '\0';
+
+	if (sscanf(cmd, "%7s %lx %lx %d", op, &addr, &size, &pid) < 3)
+		return -EINVAL;
+
+	if (pid) {
+		rcu_read_lock();
+		task = find_task_by_vpid(pid);
+		if (task)
+			get_task_struct(task);
+		rcu_read_unlock();
+
+		if (!task)
+			return -ESRCH;
+
+		mm = get_task_mm(task);
+		put_task_struct(task);
+
+		if (!mm)
+			return -EINVAL;
+	}
+
+	ret = 0;
+	if (!strcmp(op, "wire"))
+		ret = tlb_wire_range(mm, addr, size);
+	else if (!strcmp(op, "unwire"))
+		tlb_unwire_range(mm, addr, size);
+	else
+		ret = -EINVAL;
+
+	if (mm)
+		mmput(mm);
+
+	return ret ? ret : count;
+}
+
+static const struct file_operations tlb_wired_debugfs_fops = {
+	.owner		= THIS_MODULE,
+	.open		= tlb_wired_debugfs_open,
+	.read		= seq_read,
+	.write		= tlb_wired_debugfs_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init tlb_wired_debugfs_init(void)
+{
+	struct dentry *dentry;
+
+	dentry = debugfs_create_file("tlb_wired", S_IRUSR | S_IWUSR,
+				     sh_debugfs_root, NULL,
+				     &tlb_wired_debugfs_fops);
+	if (!dentry)
+		return -ENOMEM;
+	if (IS_ERR(dentry))
+		return PTR_ERR(dentry);
+
+	return 0;
 }
+module_init(tlb_wired_debugfs_init);
+#endif
@@ -12,6 +12,19 @@
 #include <asm/mmu_context.h>
 #include <asm/tlbflush.h>
 
+/*
+ * Ranges up to this many pages are invalidated page by page, keeping
+ * the ASID; anything larger gives up the context instead. SH-4 does
+ * the whole batch in a single pass through P2 (see tlb-sh4.c), which
+ * makes flushing every UTLB entry's worth of pages cheaper than the
+ * ASID churn and refaults that dropping the context costs.
+ */
+#ifdef CONFIG_CPU_SH4
+#define FLUSH_RANGE_PAGES	MMU_NTLB_ENTRIES
+#else
+#define FLUSH_RANGE_PAGES	(MMU_NTLB_ENTRIES/4)
+#endif
+
 void local_flush_tlb_page(struct vm_area_struct *vma, unsigned long page)
 {
 	unsigned int cpu = smp_processor_id();
@@ -30,6 +43,7 @@ void local_flush_tlb_page(struct vm_area_struct *vma, unsigned long page)
 			set_asid(asid);
 		}
 		local_flush_tlb_one(asid, page);
+		tlb_stat_inc(cpu, TLB_STAT_FLUSH_PAGE);
 		if (saved_asid != MMU_NO_ASID)
 			set_asid(saved_asid);
 		local_irq_restore(flags);
@@ -48,7 +62,8 @@ void local_flush_tlb_range(struct vm_area_struct *vma, unsigned long start,
 
 		local_irq_save(flags);
 		size = (end - start + (PAGE_SIZE - 1)) >> PAGE_SHIFT;
-		if (size > (MMU_NTLB_ENTRIES/4)) { /* Too many TLB to flush */
+		if (size > FLUSH_RANGE_PAGES) { /* Too many TLB to flush */
+			tlb_stat_inc(cpu, TLB_STAT_FLUSH_RANGE_CONTEXT);
 			cpu_context(cpu, mm) = NO_CONTEXT;
 			if (mm == current->mm)
 				activate_context(mm, cpu);
@@ -64,10 +79,9 @@ void local_flush_tlb_range(struct vm_area_struct *vma, unsigned long start,
 				saved_asid = get_asid();
 				set_asid(asid);
 			}
-			while (start < end) {
-				local_flush_tlb_one(asid, start);
-				start += PAGE_SIZE;
-			}
+			local_flush_tlb_pages(asid, start, end);
+			tlb_stat_inc(cpu, TLB_STAT_FLUSH_RANGE);
+			tlb_stat_add(cpu, TLB_STAT_FLUSH_RANGE_PAGES, size);
 			if (saved_asid != MMU_NO_ASID)
 				set_asid(saved_asid);
 		}
@@ -83,7 +97,8 @@ void local_flush_tlb_kernel_range(unsigned long start, unsigned long end)
 
 	local_irq_save(flags);
 	size = (end - start + (PAGE_SIZE - 1)) >> PAGE_SHIFT;
-	if (size > (MMU_NTLB_ENTRIES/4)) { /* Too many TLB to flush */
+	if (size > FLUSH_RANGE_PAGES) { /* Too many TLB to flush */
+		tlb_stat_inc(cpu, TLB_STAT_FLUSH_KERNEL_RANGE_ALL);
 		local_flush_tlb_all();
 	} else {
 		unsigned long asid;
@@ -94,10 +109,8 @@ void local_flush_tlb_kernel_range(unsigned long start, unsigned long end)
 		end += (PAGE_SIZE - 1);
 		end &= PAGE_MASK;
 		set_asid(asid);
-		while (start < end) {
-			local_flush_tlb_one(asid, start);
-			start += PAGE_SIZE;
-		}
+		local_flush_tlb_pages(asid, start, end);
+		tlb_stat_inc(cpu, TLB_STAT_FLUSH_KERNEL_RANGE);
 		set_asid(saved_asid);
 	}
 	local_irq_restore(flags);
@@ -113,6 +126,7 @@ void local_flush_tlb_mm(struct mm_struct *mm)
 		unsigned long flags;
 
 		local_irq_save(flags);
+		tlb_stat_inc(cpu, TLB_STAT_FLUSH_MM);
 		cpu_context(cpu, mm) = NO_CONTEXT;
 		if (mm == current->mm)
 			activate_context(mm, cpu);
@@ -132,6 +146,7 @@ void local_flush_tlb_all(void)
 	 *      It's same position, bit #2.
 	 */
 	local_irq_save(flags);
+	tlb_stat_inc(smp_processor_id(), TLB_STAT_FLUSH_ALL);
 	status = __raw_readl(MMUCR);
 	status |= 0x04;
 	__raw_writel(status, MMUCR);
@@ -20,6 +20,7 @@
 #include <linux/init.h>
 #include <linux/platform_device.h>
 #include <linux/spinlock.h>
+#include <linux/seqlock.h>
 #include <linux/interrupt.h>
 #include <linux/ioport.h>
 #include <linux/io.h>
@@ -29,6 +30,7 @@
 #include <linux/clocksource.h>
 #include <linux/clockchips.h>
 #include <linux/sh_timer.h>
+#include <asm/sched_clock.h>
 
 struct sh_cmt_priv {
 	void __iomem *mapbase;
@@ -46,6 +48,7 @@ struct sh_cmt_priv {
 	unsigned long max_match_value;
 	unsigned long rate;
 	spinlock_t lock;
+	seqcount_t seq; /* total_cycles, match_value and CMCOR/CMCSR */
 	struct clock_event_device ced;
 	struct clocksource cs;
 	unsigned long total_cycles;
@@ -58,7 +61,8 @@ static DEFINE_SPINLOCK(sh_cmt_lock);
 #define CMCNT 1 /* channel register */
 #define CMCOR 2 /* channel register */
 
-static inline unsigned long sh_cmt_read(struct sh_cmt_priv *p, int reg_nr)
+static inline unsigned long notrace sh_cmt_read(struct sh_cmt_priv *p,
+					       int reg_nr)
 {
 	struct sh_timer_config *cfg = p->pdev->dev.platform_data;
 	void __iomem *base = p->mapbase;
@@ -81,8 +85,8 @@ static inline unsigned long sh_cmt_read(struct sh_cmt_priv *p, int reg_nr)
 	return ioread16(base + offs);
 }
 
-static inline void sh_cmt_write(struct sh_cmt_priv *p, int reg_nr,
-				unsigned long value)
+static inline void notrace sh_cmt_write(struct sh_cmt_priv *p, int reg_nr,
+					unsigned long value)
 {
 	struct sh_timer_config *cfg = p->pdev->dev.platform_data;
 	void __iomem *base = p->mapbase;
@@ -107,8 +111,8 @@ static inline void sh_cmt_write(struct sh_cmt_priv *p, int reg_nr,
 	iowrite16(value, base + offs);
 }
 
-static unsigned long sh_cmt_get_counter(struct sh_cmt_priv *p,
-					int *has_wrapped)
+static unsigned long notrace sh_cmt_get_counter(struct sh_cmt_priv *p,
+						int *has_wrapped)
 {
 	unsigned long v1, v2, v3;
 	int o1, o2;
@@ -199,8 +203,8 @@ static void sh_cmt_disable(struct sh_cmt_priv *p)
 #define FLAG_SKIPEVENT (1 << 3)
 #define FLAG_IRQCONTEXT (1 << 4)
 
-static void sh_cmt_clock_event_program_verify(struct sh_cmt_priv *p,
-					      int absolute)
+static int notrace __sh_cmt_clock_event_program_verify(struct sh_cmt_priv *p,
+						       int absolute)
 {
 	unsigned long new_match;
 	unsigned long value = p->next_match_value;
@@ -217,7 +221,7 @@ static void sh_cmt_clock_event_program_verify(struct sh_cmt_priv *p,
 		 *  -> interrupt number two handles the event.
 		 */
 		p->flags |= FLAG_SKIPEVENT;
-		return;
+		return 0;
 	}
 
 	if (absolute)
@@ -279,9 +283,30 @@ static void sh_cmt_clock_event_program_verify(struct sh_cmt_priv *p,
 			delay = 1;
 
 		if (!delay)
-			pr_warning("sh_cmt: too long delay\n");
+			return -ERANGE;
 
 	} while (delay);
+
+	return 0;
+}
+
+/*
+ * CMCOR and match_value change under the clocksource read here, so this
+ * runs as a write section of p->seq. Nothing inside may end up calling
+ * sched_clock(), which would spin on the sequence count forever; that
+ * includes printk().
+ */
+static void sh_cmt_clock_event_program_verify(struct sh_cmt_priv *p,
+					      int absolute)
+{
+	int ret;
+
+	write_seqcount_begin(&p->seq);
+	ret = __sh_cmt_clock_event_program_verify(p, absolute);
+	write_seqcount_end(&p->seq);
+
+	if (ret)
+		pr_warning("sh_cmt: too long delay\n");
 }
 
 static void sh_cmt_set_next(struct sh_cmt_priv *p, unsigned long delta)
@@ -301,6 +326,12 @@ static irqreturn_t sh_cmt_interrupt(int irq, void *dev_id)
 {
 	struct sh_cmt_priv *p = dev_id;
 
+	/* clearing the wrap flag and accounting for it must look atomic
+	 * to the clocksource read, which only checks the sequence count.
+	 */
+	spin_lock(&p->lock);
+	write_seqcount_begin(&p->seq);
+
 	/* clear flags */
 	sh_cmt_write(p, CMCSR, sh_cmt_read(p, CMCSR) & p->clear_bits);
 
@@ -311,6 +342,9 @@ static irqreturn_t sh_cmt_interrupt(int irq, void *dev_id)
 	if (p->flags & FLAG_CLOCKSOURCE)
 		p->total_cycles += p->match_value;
 
+	write_seqcount_end(&p->seq);
+	spin_unlock(&p->lock);
+
 	if (!(p->flags & FLAG_REPROGRAM))
 		p->next_match_value = p->max_match_value;
 
@@ -331,7 +365,9 @@ static irqreturn_t sh_cmt_interrupt(int irq, void *dev_id)
 
 	if (p->flags & FLAG_REPROGRAM) {
 		p->flags &= ~FLAG_REPROGRAM;
+		spin_lock(&p->lock);
 		sh_cmt_clock_event_program_verify(p, 1);
+		spin_unlock(&p->lock);
 
 		if (p->flags & FLAG_CLOCKEVENT)
 			if ((p->ced.mode == CLOCK_EVT_MODE_SHUTDOWN)
@@ -392,20 +428,27 @@ static struct sh_cmt_priv *cs_to_sh_cmt(struct clocksource *cs)
 	return container_of(cs, struct sh_cmt_priv, cs);
 }
 
-static cycle_t sh_cmt_clocksource_read(struct clocksource *cs)
+/*
+ * Lockless: the counter, its wrap flag, the match value and the cycles
+ * accumulated by the interrupt handler are sampled until they are seen
+ * without a writer having touched them in between.
+ */
+static cycle_t notrace sh_cmt_clocksource_read(struct clocksource *cs)
 {
 	struct sh_cmt_priv *p = cs_to_sh_cmt(cs);
-	unsigned long flags, raw;
-	unsigned long value;
+	unsigned long raw, value, match;
+	unsigned int seq;
 	int has_wrapped;
 
-	spin_lock_irqsave(&p->lock, flags);
-	value = p->total_cycles;
-	raw = sh_cmt_get_counter(p, &has_wrapped);
+	do {
+		seq = read_seqcount_begin(&p->seq);
+		value = p->total_cycles;
+		match = p->match_value;
+		raw = sh_cmt_get_counter(p, &has_wrapped);
+	} while (read_seqcount_retry(&p->seq, seq));
 
 	if (unlikely(has_wrapped))
-		raw += p->match_value;
-	spin_unlock_irqrestore(&p->lock, flags);
+		raw += match;
 
 	return value + raw;
 }
@@ -424,11 +467,14 @@ static int sh_cmt_clocksource_enable(struct clocksource *cs)
 	/* TODO: calculate good shift from rate and counter bit width */
 	cs->shift = 0;
 	cs->mult = clocksource_hz2mult(p->rate, cs->shift);
+
+	sh_sched_clock_start(cs);
 	return 0;
 }
 
 static void sh_cmt_clocksource_disable(struct clocksource *cs)
 {
+	sh_sched_clock_stop(cs);
 	sh_cmt_stop(cs_to_sh_cmt(cs), FLAG_CLOCKSOURCE);
 }
 
@@ -445,6 +491,11 @@ static int sh_cmt_register_clocksource(struct sh_cmt_priv *p,
 	cs->mask = CLOCKSOURCE_MASK(sizeof(unsigned long) * 8);
 	cs->flags = CLOCK_SOURCE_IS_CONTINUOUS;
 	pr_info("sh_cmt: %s used as clock source\n", cs->name);
+
+	/* the read path takes no locks, good for sched_clock() too */
+	sh_sched_clock_register(cs, clk_get_rate(p->clk) /
+				(p->width == 16 ? 512 : 8));
+
 	clocksource_register(cs);
 	return 0;
 }
@@ -552,6 +603,7 @@ static int sh_cmt_register(struct sh_cmt_priv *p, char *name,
 
 	p->match_value = p->max_match_value;
 	spin_lock_init(&p->lock);
+	seqcount_init(&p->seq);
 
 	if (clockevent_rating)
 		sh_cmt_register_clockevent(p, name, clockevent_rating);
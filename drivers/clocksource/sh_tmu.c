@@ -30,6 +30,8 @@
 #include <linux/clocksource.h>
 #include <linux/clockchips.h>
 #include <linux/sh_timer.h>
+#include <asm/vdso.h>
+#include <asm/sched_clock.h>
 
 struct sh_tmu_priv {
 	void __iomem *mapbase;
@@ -189,7 +191,7 @@ static struct sh_tmu_priv *cs_to_sh_tmu(struct clocksource *cs)
 	return container_of(cs, struct sh_tmu_priv, cs);
 }
 
-static cycle_t sh_tmu_clocksource_read(struct clocksource *cs)
+static cycle_t notrace sh_tmu_clocksource_read(struct clocksource *cs)
 {
 	struct sh_tmu_priv *p = cs_to_sh_tmu(cs);
 
@@ -208,11 +210,14 @@ static int sh_tmu_clocksource_enable(struct clocksource *cs)
 	/* TODO: calculate good shift from rate and counter bit width */
 	cs->shift = 10;
 	cs->mult = clocksource_hz2mult(p->rate, cs->shift);
+
+	sh_sched_clock_start(cs);
 	return 0;
 }
 
 static void sh_tmu_clocksource_disable(struct clocksource *cs)
 {
+	sh_sched_clock_stop(cs);
 	sh_tmu_disable(cs_to_sh_tmu(cs));
 }
 
@@ -220,6 +225,8 @@ static int sh_tmu_register_clocksource(struct sh_tmu_priv *p,
 				       char *name, unsigned long rating)
 {
 	struct clocksource *cs = &p->cs;
+	struct resource *res = platform_get_resource(p->pdev,
+						     IORESOURCE_MEM, 0);
 
 	cs->name = name;
 	cs->rating = rating;
@@ -229,6 +236,13 @@ static int sh_tmu_register_clocksource(struct sh_tmu_priv *p,
 	cs->mask = CLOCKSOURCE_MASK(32);
 	cs->flags = CLOCK_SOURCE_IS_CONTINUOUS;
 	pr_info("sh_tmu: %s used as clock source\n", cs->name);
+
+	/* TCNT is free running, user space can read it as well */
+	vdso_register_counter(cs, res->start + (TCNT << 2), 0xffffffff);
+
+	/* TCNT is free running and lockless, good for sched_clock() too */
+	sh_sched_clock_register(cs, clk_get_rate(p->clk) / 4);
+
 	clocksource_register(cs);
 	return 0;
 }
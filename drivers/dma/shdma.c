@@ -12,7 +12,8 @@
  * the Free Software Foundation; either version 2 of the License, or
  * (at your option) any later version.
  *
- * - DMA of SuperH does not have Hardware DMA chain mode.
+ * - DMA of SuperH does not have Hardware DMA chain mode, but channels with
+ *   the reload function can have the next chunk queued up in SARB/DARB/TCRB.
  * - MAX DMA size is 16MB.
  *
  */
@@ -24,6 +25,10 @@
 #include <linux/delay.h>
 #include <linux/dma-mapping.h>
 #include <linux/platform_device.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/math64.h>
+#include <linux/slab.h>
 #include <cpu/dma.h>
 #include <asm/dma-sh.h>
 #include "shdma.h"
@@ -131,6 +136,33 @@ static void dmae_halt(struct sh_dmae_chan *sh_chan)
 	u32 chcr = sh_dmae_readl(sh_chan, CHCR);
 
 	chcr &= ~(CHCR_DE | CHCR_TE | CHCR_IE);
+	if (sh_chan->reload)
+		chcr &= ~CHCR_RPT_MASK;
+	sh_dmae_writel(sh_chan, chcr, CHCR);
+}
+
+/*
+ * Queue @hw up for the reload function, or let the channel stop after the
+ * current chunk if @hw is NULL. Also acknowledges a pending transfer end.
+ *
+ * The DMAC copies the B registers into SAR/DAR/TCR at the end of every
+ * chunk, but doesn't transfer anything while TE is set. The B registers
+ * are written before TE is cleared in the same CHCR write that sets or
+ * clears the reload mode, so a late interrupt only delays the next chunk
+ * and can never make the channel run one from stale B registers.
+ */
+static void dmae_set_reload(struct sh_dmae_chan *sh_chan,
+			    struct sh_dmae_regs *hw)
+{
+	u32 chcr = sh_dmae_readl(sh_chan, CHCR) & ~(CHCR_RPT_MASK | CHCR_TE);
+
+	if (hw) {
+		sh_dmae_writel(sh_chan, hw->sar, SARB);
+		sh_dmae_writel(sh_chan, hw->dar, DARB);
+		sh_dmae_writel(sh_chan, hw->tcr >> sh_chan->xmit_shift, TCRB);
+		chcr |= CHCR_RPT_RELOAD;
+	}
+
 	sh_dmae_writel(sh_chan, chcr, CHCR);
 }
 
@@ -189,7 +221,9 @@ static dma_cookie_t sh_dmae_tx_submit(struct dma_async_tx_descriptor *tx)
 	dma_async_tx_callback callback = tx->callback;
 	dma_cookie_t cookie;
 
-	spin_lock_bh(&sh_chan->desc_lock);
+	unsigned long flags;
+
+	spin_lock_irqsave(&sh_chan->desc_lock, flags);
 
 	cookie = sh_chan->common.cookie;
 	cookie++;
@@ -218,14 +252,20 @@ static dma_cookie_t sh_dmae_tx_submit(struct dma_async_tx_descriptor *tx)
 		last = chunk;
 	}
 
-	last->async_tx.callback = callback;
-	last->async_tx.callback_param = tx->callback_param;
+	if (desc->cyclic) {
+		/* Called from the tasklet after every period */
+		sh_chan->cyclic_callback = callback;
+		sh_chan->cyclic_param = tx->callback_param;
+	} else {
+		last->async_tx.callback = callback;
+		last->async_tx.callback_param = tx->callback_param;
+	}
 
 	dev_dbg(sh_chan->dev, "submit #%d@%p on %d: %x[%d] -> %x\n",
 		tx->cookie, &last->async_tx, sh_chan->id,
 		desc->hw.sar, desc->hw.tcr, desc->hw.dar);
 
-	spin_unlock_bh(&sh_chan->desc_lock);
+	spin_unlock_irqrestore(&sh_chan->desc_lock, flags);
 
 	return cookie;
 }
@@ -293,12 +333,12 @@ static int sh_dmae_alloc_chan_resources(struct dma_chan *chan)
 			dmae_set_chcr(sh_chan, RS_DEFAULT);
 	}
 
-	spin_lock_bh(&sh_chan->desc_lock);
+	spin_lock_irq(&sh_chan->desc_lock);
 	while (sh_chan->descs_allocated < NR_DESCS_PER_CHANNEL) {
-		spin_unlock_bh(&sh_chan->desc_lock);
+		spin_unlock_irq(&sh_chan->desc_lock);
 		desc = kzalloc(sizeof(struct sh_desc), GFP_KERNEL);
 		if (!desc) {
-			spin_lock_bh(&sh_chan->desc_lock);
+			spin_lock_irq(&sh_chan->desc_lock);
 			break;
 		}
 		dma_async_tx_descriptor_init(&desc->async_tx,
@@ -306,11 +346,11 @@ static int sh_dmae_alloc_chan_resources(struct dma_chan *chan)
 		desc->async_tx.tx_submit = sh_dmae_tx_submit;
 		desc->mark = DESC_IDLE;
 
-		spin_lock_bh(&sh_chan->desc_lock);
+		spin_lock_irq(&sh_chan->desc_lock);
 		list_add(&desc->node, &sh_chan->ld_free);
 		sh_chan->descs_allocated++;
 	}
-	spin_unlock_bh(&sh_chan->desc_lock);
+	spin_unlock_irq(&sh_chan->desc_lock);
 
 	return sh_chan->descs_allocated;
 }
@@ -324,7 +364,13 @@ static void sh_dmae_free_chan_resources(struct dma_chan *chan)
 	struct sh_desc *desc, *_desc;
 	LIST_HEAD(list);
 
+	spin_lock_irq(&sh_chan->desc_lock);
 	dmae_halt(sh_chan);
+	sh_chan->xfer = NULL;
+	sh_chan->xfer_next = NULL;
+	sh_chan->cyclic_callback = NULL;
+	sh_chan->periods = 0;
+	spin_unlock_irq(&sh_chan->desc_lock);
 
 	/* Prepared and not submitted descriptors can still be on the queue */
 	if (!list_empty(&sh_chan->ld_queue))
@@ -336,12 +382,12 @@ static void sh_dmae_free_chan_resources(struct dma_chan *chan)
 		clear_bit(param->slave_id, sh_dmae_slave_used);
 	}
 
-	spin_lock_bh(&sh_chan->desc_lock);
+	spin_lock_irq(&sh_chan->desc_lock);
 
 	list_splice_init(&sh_chan->ld_free, &list);
 	sh_chan->descs_allocated = 0;
 
-	spin_unlock_bh(&sh_chan->desc_lock);
+	spin_unlock_irq(&sh_chan->desc_lock);
 
 	list_for_each_entry_safe(desc, _desc, &list, node)
 		kfree(desc);
@@ -402,6 +448,8 @@ static struct sh_desc *sh_dmae_add_desc(struct sh_dmae_chan *sh_chan,
 	new->mark = DESC_PREPARED;
 	new->async_tx.flags = flags;
 	new->direction = direction;
+	new->partial = 0;
+	new->cyclic = false;
 
 	*len -= copy_size;
 	if (direction == DMA_BIDIRECTIONAL || direction == DMA_TO_DEVICE)
@@ -421,14 +469,16 @@ static struct sh_desc *sh_dmae_add_desc(struct sh_dmae_chan *sh_chan,
  * logically, the SG list is RAM and the addr variable contains slave address,
  * e.g., the FIFO I/O register. For MEMCPY direction equals DMA_BIDIRECTIONAL
  * and the SG list contains only one element and points at the source buffer.
+ * For cyclic DMA every SG element is one period and must fit into one chunk.
  */
 static struct dma_async_tx_descriptor *sh_dmae_prep_sg(struct sh_dmae_chan *sh_chan,
 	struct scatterlist *sgl, unsigned int sg_len, dma_addr_t *addr,
-	enum dma_data_direction direction, unsigned long flags)
+	enum dma_data_direction direction, unsigned long flags, bool cyclic)
 {
 	struct scatterlist *sg;
 	struct sh_desc *first = NULL, *new = NULL /* compiler... */;
 	LIST_HEAD(tx_list);
+	unsigned long irq_flags;
 	int chunks = 0;
 	int i;
 
@@ -440,7 +490,7 @@ static struct dma_async_tx_descriptor *sh_dmae_prep_sg(struct sh_dmae_chan *sh_c
 			(SH_DMA_TCR_MAX + 1);
 
 	/* Have to lock the whole loop to protect against concurrent release */
-	spin_lock_bh(&sh_chan->desc_lock);
+	spin_lock_irqsave(&sh_chan->desc_lock, irq_flags);
 
 	/*
 	 * Chaining:
@@ -476,6 +526,7 @@ static struct dma_async_tx_descriptor *sh_dmae_prep_sg(struct sh_dmae_chan *sh_c
 				goto err_get_desc;
 
 			new->chunks = chunks--;
+			new->cyclic = cyclic;
 			list_add_tail(&new->node, &tx_list);
 		} while (len);
 	}
@@ -486,7 +537,7 @@ static struct dma_async_tx_descriptor *sh_dmae_prep_sg(struct sh_dmae_chan *sh_c
 	/* Put them back on the free list, so, they don't get lost */
 	list_splice_tail(&tx_list, &sh_chan->ld_free);
 
-	spin_unlock_bh(&sh_chan->desc_lock);
+	spin_unlock_irqrestore(&sh_chan->desc_lock, irq_flags);
 
 	return &first->async_tx;
 
@@ -495,7 +546,7 @@ err_get_desc:
 		new->mark = DESC_IDLE;
 	list_splice(&tx_list, &sh_chan->ld_free);
 
-	spin_unlock_bh(&sh_chan->desc_lock);
+	spin_unlock_irqrestore(&sh_chan->desc_lock, irq_flags);
 
 	return NULL;
 }
@@ -521,7 +572,7 @@ static struct dma_async_tx_descriptor *sh_dmae_prep_memcpy(
 	sg_dma_len(&sg) = len;
 
 	return sh_dmae_prep_sg(sh_chan, &sg, 1, &dma_dest, DMA_BIDIRECTIONAL,
-			       flags);
+			       flags, false);
 }
 
 static struct dma_async_tx_descriptor *sh_dmae_prep_slave_sg(
@@ -549,19 +600,135 @@ static struct dma_async_tx_descriptor *sh_dmae_prep_slave_sg(
 	 * therefore param->config != NULL too.
 	 */
 	return sh_dmae_prep_sg(sh_chan, sgl, sg_len, &param->config->addr,
-			       direction, flags);
+			       direction, flags, false);
+}
+
+/*
+ * The buffer is split into one chunk per period. The chunks are submitted
+ * together and go round on the channel until sh_dmae_terminate_all(), the
+ * callback is called from the tasklet once for every period elapsed.
+ */
+static struct dma_async_tx_descriptor *sh_dmae_prep_dma_cyclic(
+	struct dma_chan *chan, dma_addr_t buf_addr, size_t buf_len,
+	size_t period_len, enum dma_data_direction direction)
+{
+	struct dma_async_tx_descriptor *tx;
+	struct sh_dmae_slave *param;
+	struct sh_dmae_chan *sh_chan;
+	struct scatterlist *sgl;
+	int i, periods;
+
+	if (!chan)
+		return NULL;
+
+	sh_chan = to_sh_chan(chan);
+	param = chan->private;
+
+	BUILD_BUG_ON(SH_DMAE_CYCLIC_PERIODS_MAX > NR_DESCS_PER_CHANNEL);
+
+	periods = period_len ? buf_len / period_len : 0;
+	if (!param || !periods || buf_len % period_len ||
+	    period_len > SH_DMA_TCR_MAX + 1) {
+		dev_warn(sh_chan->dev, "%s: bad parameter: %p, %zu/%zu\n",
+			 __func__, param, buf_len, period_len);
+		return NULL;
+	}
+
+	if (periods > SH_DMAE_CYCLIC_PERIODS_MAX) {
+		dev_warn(sh_chan->dev, "%s: %d periods, at most %d supported\n",
+			 __func__, periods, SH_DMAE_CYCLIC_PERIODS_MAX);
+		return NULL;
+	}
+
+	sgl = kcalloc(periods, sizeof(*sgl), GFP_ATOMIC);
+	if (!sgl)
+		return NULL;
+
+	sg_init_table(sgl, periods);
+	for (i = 0; i < periods; i++) {
+		sg_dma_address(&sgl[i]) = buf_addr + i * period_len;
+		sg_dma_len(&sgl[i]) = period_len;
+	}
+
+	tx = sh_dmae_prep_sg(sh_chan, sgl, periods, &param->config->addr,
+			     direction, DMA_PREP_INTERRUPT | DMA_CTRL_ACK, true);
+	kfree(sgl);
+
+	return tx;
 }
 
 static void sh_dmae_terminate_all(struct dma_chan *chan)
 {
 	struct sh_dmae_chan *sh_chan = to_sh_chan(chan);
+	struct sh_desc *desc;
+	unsigned long flags;
+	bool busy;
 
 	if (!chan)
 		return;
 
+	/* Audio drivers stop their streams with interrupts disabled */
+	spin_lock_irqsave(&sh_chan->desc_lock, flags);
+	busy = dmae_is_busy(sh_chan);
+	dmae_halt(sh_chan);
+
+	/* Record how far the chunk in flight got, slave drivers need it */
+	desc = sh_chan->xfer;
+	if (busy && desc) {
+		desc->partial = desc->hw.tcr -
+			(sh_dmae_readl(sh_chan, TCR) << sh_chan->xmit_shift);
+		sh_chan->stats.busy_ns += ktime_to_ns(ktime_sub(ktime_get(),
+							sh_chan->busy_since));
+	}
+
+	sh_chan->xfer = NULL;
+	sh_chan->xfer_next = NULL;
+	sh_chan->cyclic_callback = NULL;
+	sh_chan->periods = 0;
+	spin_unlock_irqrestore(&sh_chan->desc_lock, flags);
+
 	sh_dmae_chan_ld_cleanup(sh_chan, true);
 }
 
+/**
+ * sh_dmae_get_position - where a slave channel currently is in memory
+ * @chan:	DMA channel
+ *
+ * Returns the RAM address the channel is going to access next, that is the
+ * source address for DMA_TO_DEVICE and the destination for DMA_FROM_DEVICE,
+ * or 0 if the channel is idle. Audio drivers use this for their pointer.
+ */
+dma_addr_t sh_dmae_get_position(struct dma_chan *chan)
+{
+	struct sh_dmae_chan *sh_chan = to_sh_chan(chan);
+	dma_addr_t pos = 0;
+	unsigned long flags;
+
+	spin_lock_irqsave(&sh_chan->desc_lock, flags);
+	if (sh_chan->xfer)
+		pos = sh_dmae_readl(sh_chan,
+			sh_chan->xfer->direction == DMA_FROM_DEVICE ?
+			DAR : SAR);
+	spin_unlock_irqrestore(&sh_chan->desc_lock, flags);
+
+	return pos;
+}
+EXPORT_SYMBOL_GPL(sh_dmae_get_position);
+
+/**
+ * sh_dmae_get_partial - how far a terminated descriptor got
+ * @tx:		descriptor that was in flight when device_terminate_all() ran
+ *
+ * Returns the number of bytes the descriptor had moved when the channel was
+ * halted, 0 if it hadn't started. Slave drivers that stop a transfer early,
+ * such as a serial port on an Rx timeout, use this to find the data.
+ */
+size_t sh_dmae_get_partial(struct dma_async_tx_descriptor *tx)
+{
+	return tx_to_sh_desc(tx)->partial;
+}
+EXPORT_SYMBOL_GPL(sh_dmae_get_partial);
+
 static dma_async_tx_callback __ld_cleanup(struct sh_dmae_chan *sh_chan, bool all)
 {
 	struct sh_desc *desc, *_desc;
@@ -570,8 +737,9 @@ static dma_async_tx_callback __ld_cleanup(struct sh_dmae_chan *sh_chan, bool all
 	dma_cookie_t cookie = 0;
 	dma_async_tx_callback callback = NULL;
 	void *param = NULL;
+	unsigned long flags;
 
-	spin_lock_bh(&sh_chan->desc_lock);
+	spin_lock_irqsave(&sh_chan->desc_lock, flags);
 	list_for_each_entry_safe(desc, _desc, &sh_chan->ld_queue, node) {
 		struct dma_async_tx_descriptor *tx = &desc->async_tx;
 
@@ -640,7 +808,7 @@ static dma_async_tx_callback __ld_cleanup(struct sh_dmae_chan *sh_chan, bool all
 			list_move(&desc->node, &sh_chan->ld_free);
 		}
 	}
-	spin_unlock_bh(&sh_chan->desc_lock);
+	spin_unlock_irqrestore(&sh_chan->desc_lock, flags);
 
 	if (callback)
 		callback(param);
@@ -659,27 +827,77 @@ static void sh_dmae_chan_ld_cleanup(struct sh_dmae_chan *sh_chan, bool all)
 		;
 }
 
-static void sh_chan_xfer_ld_queue(struct sh_dmae_chan *sh_chan)
+/* Called with desc_lock held: the chunk to transfer after @desc, if any */
+static struct sh_desc *dmae_next_desc(struct sh_dmae_chan *sh_chan,
+				      struct sh_desc *desc)
+{
+	struct sh_desc *next = desc;
+
+	list_for_each_entry_continue(next, &sh_chan->ld_queue, node)
+		if (next->mark == DESC_SUBMITTED)
+			return next;
+
+	/* A cyclic transfer has the channel to itself, go round */
+	if (desc->cyclic)
+		return list_first_entry(&sh_chan->ld_queue, struct sh_desc,
+					node);
+
+	return NULL;
+}
+
+/* Called with desc_lock held and the channel stopped */
+static void dmae_start_desc(struct sh_dmae_chan *sh_chan, struct sh_desc *sd)
+{
+	struct sh_desc *next = NULL;
+
+	/*
+	 * Only slave transfers are paced slowly enough to be sure we refill
+	 * the B registers before the DMAC gets to them again.
+	 */
+	if (sh_chan->reload && sh_chan->common.private)
+		next = dmae_next_desc(sh_chan, sd);
+
+	dmae_set_reg(sh_chan, &sd->hw);
+	if (sh_chan->reload)
+		dmae_set_reload(sh_chan, next ? &next->hw : NULL);
+
+	sh_chan->xfer = sd;
+	sh_chan->xfer_next = next;
+	sh_chan->busy_since = ktime_get();
+	sh_chan->stats.restarts++;
+
+	dmae_start(sh_chan);
+}
+
+/*
+ * Called with desc_lock held. Once a chunk has been started, the chain is
+ * owned by the transfer end interrupt until it runs dry: between the end
+ * of a chunk and sh_dmae_interrupt() the channel reads as idle, but the
+ * chunk in sh_chan->xfer is still DESC_SUBMITTED and must not be started
+ * a second time.
+ */
+static void __sh_chan_xfer_ld_queue(struct sh_dmae_chan *sh_chan)
 {
 	struct sh_desc *sd;
 
-	spin_lock_bh(&sh_chan->desc_lock);
-	/* DMA work check */
-	if (dmae_is_busy(sh_chan)) {
-		spin_unlock_bh(&sh_chan->desc_lock);
+	if (sh_chan->xfer || dmae_is_busy(sh_chan))
 		return;
-	}
 
 	/* Find the first not transferred desciptor */
 	list_for_each_entry(sd, &sh_chan->ld_queue, node)
 		if (sd->mark == DESC_SUBMITTED) {
-			/* Get the ld start address from ld_queue */
-			dmae_set_reg(sh_chan, &sd->hw);
-			dmae_start(sh_chan);
+			dmae_start_desc(sh_chan, sd);
 			break;
 		}
+}
 
-	spin_unlock_bh(&sh_chan->desc_lock);
+static void sh_chan_xfer_ld_queue(struct sh_dmae_chan *sh_chan)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&sh_chan->desc_lock, flags);
+	__sh_chan_xfer_ld_queue(sh_chan);
+	spin_unlock_irqrestore(&sh_chan->desc_lock, flags);
 }
 
 static void sh_dmae_memcpy_issue_pending(struct dma_chan *chan)
@@ -712,20 +930,75 @@ static enum dma_status sh_dmae_is_complete(struct dma_chan *chan,
 	return dma_async_is_complete(cookie, last_complete, last_used);
 }
 
+/*
+ * Called with desc_lock held from the transfer end interrupt. The next chunk
+ * is started right here rather than from the tasklet, so that it follows
+ * the previous one as closely as possible. With the reload function it is
+ * already running and we only have to queue up the one after it.
+ */
+static void sh_dmae_xfer_done(struct sh_dmae_chan *sh_chan)
+{
+	struct sh_desc *desc = sh_chan->xfer, *next;
+	struct sh_dmae_stats *stats = &sh_chan->stats;
+	ktime_t now = ktime_get();
+
+	sh_chan->te_stamp = now;
+	stats->busy_ns += ktime_to_ns(ktime_sub(now, sh_chan->busy_since));
+	sh_chan->busy_since = now;
+
+	if (!desc) {
+		/* Terminated under our feet */
+		dmae_halt(sh_chan);
+		return;
+	}
+
+	dev_dbg(sh_chan->dev, "done #%d@%p dst %u\n",
+		desc->async_tx.cookie, &desc->async_tx, desc->hw.dar);
+
+	stats->xfers++;
+	stats->bytes += desc->hw.tcr;
+	if (desc->cyclic) {
+		sh_chan->periods++;
+		stats->periods++;
+	} else {
+		desc->mark = DESC_COMPLETED;
+	}
+
+	if (sh_chan->xfer_next) {
+		desc = sh_chan->xfer_next;
+		next = dmae_next_desc(sh_chan, desc);
+		dmae_set_reload(sh_chan, next ? &next->hw : NULL);
+		sh_chan->xfer = desc;
+		sh_chan->xfer_next = next;
+		stats->reloads++;
+		return;
+	}
+
+	next = dmae_next_desc(sh_chan, desc);
+	dmae_halt(sh_chan);
+	sh_chan->xfer = NULL;
+	if (next)
+		dmae_start_desc(sh_chan, next);
+}
+
 static irqreturn_t sh_dmae_interrupt(int irq, void *data)
 {
 	irqreturn_t ret = IRQ_NONE;
 	struct sh_dmae_chan *sh_chan = (struct sh_dmae_chan *)data;
-	u32 chcr = sh_dmae_readl(sh_chan, CHCR);
+	u32 chcr;
 
+	spin_lock(&sh_chan->desc_lock);
+
+	chcr = sh_dmae_readl(sh_chan, CHCR);
 	if (chcr & CHCR_TE) {
-		/* DMA stop */
-		dmae_halt(sh_chan);
+		sh_dmae_xfer_done(sh_chan);
 
 		ret = IRQ_HANDLED;
 		tasklet_schedule(&sh_chan->tasklet);
 	}
 
+	spin_unlock(&sh_chan->desc_lock);
+
 	return ret;
 }
 
@@ -772,27 +1045,38 @@ static irqreturn_t sh_dmae_err(int irq, void *data)
 static void dmae_do_tasklet(unsigned long data)
 {
 	struct sh_dmae_chan *sh_chan = (struct sh_dmae_chan *)data;
-	struct sh_desc *desc;
-	u32 sar_buf = sh_dmae_readl(sh_chan, SAR);
-	u32 dar_buf = sh_dmae_readl(sh_chan, DAR);
+	struct sh_dmae_stats *stats = &sh_chan->stats;
+	dma_async_tx_callback callback;
+	void *param;
+	u64 latency;
 
-	spin_lock(&sh_chan->desc_lock);
-	list_for_each_entry(desc, &sh_chan->ld_queue, node) {
-		if (desc->mark == DESC_SUBMITTED &&
-		    ((desc->direction == DMA_FROM_DEVICE &&
-		      (desc->hw.dar + desc->hw.tcr) == dar_buf) ||
-		     (desc->hw.sar + desc->hw.tcr) == sar_buf)) {
-			dev_dbg(sh_chan->dev, "done #%d@%p dst %u\n",
-				desc->async_tx.cookie, &desc->async_tx,
-				desc->hw.dar);
-			desc->mark = DESC_COMPLETED;
+	spin_lock_irq(&sh_chan->desc_lock);
+
+	latency = ktime_to_ns(ktime_sub(ktime_get(), sh_chan->te_stamp));
+	stats->tasklets++;
+	stats->latency_ns += latency;
+	if (latency > stats->latency_max_ns)
+		stats->latency_max_ns = latency;
+
+	/*
+	 * Report one period at a time and look at the channel again before
+	 * each: sh_dmae_terminate_all() clears the callback under the lock,
+	 * and no period may be reported once it has returned.
+	 */
+	for (;;) {
+		callback = sh_chan->cyclic_callback;
+		param = sh_chan->cyclic_param;
+		if (!callback || !sh_chan->periods)
 			break;
-		}
+		sh_chan->periods--;
+
+		spin_unlock_irq(&sh_chan->desc_lock);
+		callback(param);
+		spin_lock_irq(&sh_chan->desc_lock);
 	}
-	spin_unlock(&sh_chan->desc_lock);
 
-	/* Next desc */
-	sh_chan_xfer_ld_queue(sh_chan);
+	spin_unlock_irq(&sh_chan->desc_lock);
+
 	sh_dmae_chan_ld_cleanup(sh_chan, false);
 }
 
@@ -821,6 +1105,9 @@ static int __devinit sh_dmae_chan_probe(struct sh_dmae_device *shdev, int id)
 
 	new_sh_chan->dev = shdev->common.dev;
 	new_sh_chan->id = id;
+	/* The B registers only exist on the first four channels of a DMAC */
+	new_sh_chan->reload = (shdev->pdata.mode & SHDMA_RELOAD) &&
+		id % 6 < 4;
 
 	/* Init DMA tasklet */
 	tasklet_init(&new_sh_chan->tasklet, dmae_do_tasklet,
@@ -893,6 +1180,80 @@ static void sh_dmae_chan_remove(struct sh_dmae_device *shdev)
 	shdev->common.chancnt = 0;
 }
 
+#ifdef CONFIG_DEBUG_FS
+static int sh_dmae_stats_show(struct seq_file *s, void *unused)
+{
+	struct sh_dmae_device *shdev = s->private;
+	struct sh_dmae_stats st;
+	u64 kibps, latency;
+	int i;
+
+	seq_printf(s, "chan    xfers        bytes    KiB/s  reloads restarts"
+		   "  periods  latency avg/max (us)\n");
+
+	for (i = 0; i < MAX_DMA_CHANNELS; i++) {
+		struct sh_dmae_chan *sh_chan = shdev->chan[i];
+
+		if (!sh_chan)
+			continue;
+
+		spin_lock_irq(&sh_chan->desc_lock);
+		st = sh_chan->stats;
+		spin_unlock_irq(&sh_chan->desc_lock);
+
+		/* Throughput while busy, idle time does not count */
+		kibps = st.busy_ns ? div64_u64(st.bytes * (NSEC_PER_SEC / 1024),
+					       st.busy_ns) : 0;
+		latency = st.tasklets ? div64_u64(st.latency_ns,
+						  st.tasklets) : 0;
+
+		seq_printf(s, "%4d %8lu %12llu %8llu %8lu %8lu %8lu  %llu/%llu\n",
+			   sh_chan->id, st.xfers, st.bytes, kibps, st.reloads,
+			   st.restarts, st.periods,
+			   div64_u64(latency, NSEC_PER_USEC),
+			   div64_u64(st.latency_max_ns, NSEC_PER_USEC));
+	}
+
+	return 0;
+}
+
+static int sh_dmae_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, sh_dmae_stats_show, inode->i_private);
+}
+
+static const struct file_operations sh_dmae_stats_fops = {
+	.owner		= THIS_MODULE,
+	.open		= sh_dmae_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static void sh_dmae_debugfs_init(struct sh_dmae_device *shdev)
+{
+	shdev->debugfs = debugfs_create_dir(dev_name(shdev->common.dev), NULL);
+	if (!shdev->debugfs)
+		return;
+
+	debugfs_create_file("stats", S_IRUGO, shdev->debugfs, shdev,
+			    &sh_dmae_stats_fops);
+}
+
+static void sh_dmae_debugfs_remove(struct sh_dmae_device *shdev)
+{
+	debugfs_remove_recursive(shdev->debugfs);
+}
+#else
+static inline void sh_dmae_debugfs_init(struct sh_dmae_device *shdev)
+{
+}
+
+static inline void sh_dmae_debugfs_remove(struct sh_dmae_device *shdev)
+{
+}
+#endif /* CONFIG_DEBUG_FS */
+
 static int __init sh_dmae_probe(struct platform_device *pdev)
 {
 	int err = 0, cnt, ecnt;
@@ -936,6 +1297,7 @@ static int __init sh_dmae_probe(struct platform_device *pdev)
 
 	dma_cap_set(DMA_MEMCPY, shdev->common.cap_mask);
 	dma_cap_set(DMA_SLAVE, shdev->common.cap_mask);
+	dma_cap_set(DMA_CYCLIC, shdev->common.cap_mask);
 
 	shdev->common.device_alloc_chan_resources
 		= sh_dmae_alloc_chan_resources;
@@ -947,6 +1309,7 @@ static int __init sh_dmae_probe(struct platform_device *pdev)
 	/* Compulsory for DMA_SLAVE fields */
 	shdev->common.device_prep_slave_sg = sh_dmae_prep_slave_sg;
 	shdev->common.device_terminate_all = sh_dmae_terminate_all;
+	shdev->common.device_prep_dma_cyclic = sh_dmae_prep_dma_cyclic;
 
 	shdev->common.dev = &pdev->dev;
 	/* Default transfer size of 32 bytes requires 32-byte alignment */
@@ -983,6 +1346,7 @@ static int __init sh_dmae_probe(struct platform_device *pdev)
 
 	platform_set_drvdata(pdev, shdev);
 	dma_async_device_register(&shdev->common);
+	sh_dmae_debugfs_init(shdev);
 
 	return err;
 
@@ -1003,6 +1367,7 @@ static int __exit sh_dmae_remove(struct platform_device *pdev)
 {
 	struct sh_dmae_device *shdev = platform_get_drvdata(pdev);
 
+	sh_dmae_debugfs_remove(shdev);
 	dma_async_device_unregister(&shdev->common);
 
 	if (shdev->pdata.mode & SHDMA_MIX_IRQ) {
@@ -1046,7 +1411,8 @@ static int __init sh_dmae_init(void)
 {
 	return platform_driver_probe(&sh_dmae_driver, sh_dmae_probe);
 }
-module_init(sh_dmae_init);
+/* Slave drivers request their channels at probe time, be there before them */
+subsys_initcall(sh_dmae_init);
 
 static void __exit sh_dmae_exit(void)
 {
@@ -16,6 +16,7 @@
 #include <linux/dmaengine.h>
 #include <linux/interrupt.h>
 #include <linux/list.h>
+#include <linux/ktime.h>
 
 #define SH_DMA_TCR_MAX 0x00FFFFFF	/* 16MB */
 
@@ -31,12 +32,26 @@ struct sh_desc {
 	struct dma_async_tx_descriptor async_tx;
 	enum dma_data_direction direction;
 	dma_cookie_t cookie;
+	size_t partial;		/* Bytes moved before device_terminate_all() */
 	int chunks;
 	int mark;
+	bool cyclic;		/* Part of a cyclic transfer, never completes */
 };
 
 struct device;
 
+struct sh_dmae_stats {
+	unsigned long xfers;		/* chunks transferred */
+	unsigned long reloads;		/* chunks started by the reload function */
+	unsigned long restarts;		/* chunks started by the CPU */
+	unsigned long periods;		/* cyclic periods elapsed */
+	unsigned long tasklets;		/* completion tasklet runs */
+	u64 bytes;
+	u64 busy_ns;			/* time spent transferring */
+	u64 latency_ns;			/* transfer end irq to tasklet, total */
+	u64 latency_max_ns;
+};
+
 struct sh_dmae_chan {
 	dma_cookie_t completed_cookie;	/* The maximum cookie completed */
 	spinlock_t desc_lock;		/* Descriptor operation lock */
@@ -49,12 +64,22 @@ struct sh_dmae_chan {
 	int xmit_shift;			/* log_2(bytes_per_xfer) */
 	int id;				/* Raw id of this channel */
 	char dev_id[16];		/* unique name per DMAC of channel */
+	bool reload;			/* Channel has SARB/DARB/TCRB */
+	struct sh_desc *xfer;		/* Chunk in SAR/DAR/TCR */
+	struct sh_desc *xfer_next;	/* Chunk in SARB/DARB/TCRB */
+	unsigned int periods;		/* Cyclic periods not reported yet */
+	dma_async_tx_callback cyclic_callback;
+	void *cyclic_param;
+	ktime_t busy_since;
+	ktime_t te_stamp;		/* Last transfer end interrupt */
+	struct sh_dmae_stats stats;
 };
 
 struct sh_dmae_device {
 	struct dma_device common;
 	struct sh_dmae_chan *chan[MAX_DMA_CHANNELS];
 	struct sh_dmae_pdata pdata;
+	struct dentry *debugfs;
 };
 
 #define to_sh_chan(chan) container_of(chan, struct sh_dmae_chan, common)
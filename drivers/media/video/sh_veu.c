@@ -0,0 +1,1097 @@
+/*
+ * V4L2 mem-to-mem driver for the SuperH Mobile VEU3F
+ *
+ * The VEU scales and converts YCbCr/RGB frames from memory to memory.
+ * Every VEU gets a video node, an open file is a context with an OUTPUT
+ * queue for source frames and a CAPTURE queue for the results. A frame
+ * pair becomes a job on a list shared by all VEUs, and whichever VEU is
+ * idle first runs it, so several pipelines can use both units at once.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/init.h>
+#include <linux/module.h>
+#include <linux/io.h>
+#include <linux/dma-mapping.h>
+#include <linux/errno.h>
+#include <linux/fs.h>
+#include <linux/interrupt.h>
+#include <linux/kernel.h>
+#include <linux/mm.h>
+#include <linux/poll.h>
+#include <linux/slab.h>
+#include <linux/time.h>
+#include <linux/version.h>
+#include <linux/device.h>
+#include <linux/platform_device.h>
+#include <linux/videodev2.h>
+#include <linux/pm_runtime.h>
+#include <linux/sched.h>
+#include <linux/timer.h>
+
+#include <media/v4l2-common.h>
+#include <media/v4l2-dev.h>
+#include <media/v4l2-device.h>
+#include <media/v4l2-ioctl.h>
+#include <media/videobuf-dma-contig.h>
+
+/* register offsets for sh7724 */
+
+#define VEU_STR   0x00 /* VEU start register */
+#define VEU_SWR   0x10 /* source memory width register */
+#define VEU_SSR   0x14 /* source input size register */
+#define VEU_SAYR  0x18 /* source Y address register */
+#define VEU_SACR  0x1c /* source C address register */
+#define VEU_BSSR  0x20 /* bundle source size register */
+#define VEU_EDWR  0x30 /* destination memory width register */
+#define VEU_DAYR  0x34 /* destination Y address register */
+#define VEU_DACR  0x38 /* destination C address register */
+#define VEU_TRCR  0x50 /* transform control register */
+#define VEU_RFCR  0x54 /* resize scale register */
+#define VEU_RFSR  0x58 /* resize clip register */
+#define VEU_ENHR  0x5c /* enhance register */
+#define VEU_FMCR  0x70 /* filter mode control register */
+#define VEU_VTCR  0x74 /* lowpass filter vertical control register */
+#define VEU_HTCR  0x78 /* lowpass filter horizontal control register */
+#define VEU_APCR  0x80 /* color match register */
+#define VEU_ECCR  0x84 /* color replace register */
+#define VEU_AFXR  0x90 /* fixed mode register */
+#define VEU_SWPR  0x94 /* swap register */
+#define VEU_EIER  0xa0 /* event interrupt enable register */
+#define VEU_EVTR  0xa4 /* event register */
+#define VEU_STAR  0xb0 /* status register */
+#define VEU_BSRR  0xb4 /* reset register */
+
+#define VEU_STR_START		(1 << 0)
+#define VEU_EIER_END		(1 << 0) /* frame end interrupt */
+#define VEU_BSRR_RESET		(1 << 8)
+#define VEU_SWPR_MAGIC		0x67 /* little endian pixels, as libshveu */
+
+#define VEU_TRCR_DST_YCBCR420	(0 << 22)
+#define VEU_TRCR_DST_YCBCR422	(1 << 22)
+#define VEU_TRCR_DST_RGB565	(6 << 16)
+#define VEU_TRCR_SRC_YCBCR420	(0 << 14)
+#define VEU_TRCR_SRC_YCBCR422	(1 << 14)
+#define VEU_TRCR_SRC_RGB565	(3 << 8)
+#define VEU_TRCR_BT601		(0 << 3)
+#define VEU_TRCR_TE		(1 << 1) /* colour conversion enable */
+#define VEU_TRCR_RY_SRC_RGB	(1 << 0) /* convert RGB to YCbCr */
+
+#define VEU_MIN_SIZE		16
+#define VEU_MAX_WIDTH		2560
+#define VEU_MAX_HEIGHT		1920
+
+/* A full size frame takes a few tens of ms, this is a wedged unit */
+#define VEU_TIMEOUT		msecs_to_jiffies(500)
+
+struct sh_veu_fmt {
+	u32 fourcc;
+	const char *name;
+	unsigned int depth;	/* bits per pixel, all planes */
+	unsigned int ydepth;	/* bits per pixel in the first plane */
+	u32 trcr_src;
+	u32 trcr_dst;
+	unsigned int yuv:1;
+};
+
+static const struct sh_veu_fmt sh_veu_fmts[] = {
+	{
+		.fourcc		= V4L2_PIX_FMT_NV12,
+		.name		= "NV12",
+		.depth		= 12,
+		.ydepth		= 8,
+		.trcr_src	= VEU_TRCR_SRC_YCBCR420,
+		.trcr_dst	= VEU_TRCR_DST_YCBCR420,
+		.yuv		= 1,
+	}, {
+		.fourcc		= V4L2_PIX_FMT_NV16,
+		.name		= "NV16",
+		.depth		= 16,
+		.ydepth		= 8,
+		.trcr_src	= VEU_TRCR_SRC_YCBCR422,
+		.trcr_dst	= VEU_TRCR_DST_YCBCR422,
+		.yuv		= 1,
+	}, {
+		.fourcc		= V4L2_PIX_FMT_RGB565,
+		.name		= "RGB565",
+		.depth		= 16,
+		.ydepth		= 16,
+		.trcr_src	= VEU_TRCR_SRC_RGB565,
+		.trcr_dst	= VEU_TRCR_DST_RGB565,
+	},
+};
+
+struct sh_veu_vfmt {
+	const struct sh_veu_fmt *fmt;
+	unsigned int width;
+	unsigned int height;
+	unsigned int bytesperline;
+	unsigned int sizeimage;
+};
+
+struct sh_veu_dev;
+
+/* One per open file */
+struct sh_veu_ctx {
+	struct sh_veu_dev *veu;		/* the node that was opened */
+	struct videobuf_queue src_vq;	/* V4L2_BUF_TYPE_VIDEO_OUTPUT */
+	struct videobuf_queue dst_vq;	/* V4L2_BUF_TYPE_VIDEO_CAPTURE */
+	struct sh_veu_vfmt src;
+	struct sh_veu_vfmt dst;
+
+	/* under sh_veu_lock */
+	struct list_head src_list;
+	struct list_head dst_list;
+	struct list_head job;		/* on sh_veu_jobs while runnable */
+};
+
+struct sh_veu_dev {
+	struct v4l2_device v4l2_dev;
+	struct video_device *vdev;
+	struct list_head list;		/* on sh_veu_units */
+	void __iomem *base;
+	unsigned int irq;
+	size_t video_limit;
+
+	/* the job on the hardware, under sh_veu_lock */
+	struct sh_veu_ctx *ctx;
+	struct videobuf_buffer *src_buf;
+	struct videobuf_buffer *dst_buf;
+	struct timer_list watchdog;	/* fires if the job never ends */
+};
+
+/*
+ * sh_veu_lock protects the unit list as seen from interrupt context,
+ * the job list and all buffer lists, it is the irqlock of every queue.
+ * sh_veu_mutex serializes probe/remove against open/release.
+ */
+static DEFINE_SPINLOCK(sh_veu_lock);
+static DEFINE_MUTEX(sh_veu_mutex);
+static LIST_HEAD(sh_veu_units);
+static LIST_HEAD(sh_veu_jobs);
+static int sh_veu_users;
+
+/* CAPTURE buffer offsets for mmap(), OUTPUT buffers start at 0 */
+#define SH_VEU_DST_OFF		(1UL << 30)
+
+static void sh_veu_write(struct sh_veu_dev *veu, unsigned long reg, u32 data)
+{
+	iowrite32(data, veu->base + reg);
+}
+
+static u32 sh_veu_read(struct sh_veu_dev *veu, unsigned long reg)
+{
+	return ioread32(veu->base + reg);
+}
+
+/************************************************************************
+ * job queue
+ ************************************************************************/
+
+/* Called under sh_veu_lock */
+static void sh_veu_ctx_ready(struct sh_veu_ctx *ctx)
+{
+	if (list_empty(&ctx->job) &&
+	    !list_empty(&ctx->src_list) && !list_empty(&ctx->dst_list))
+		list_add_tail(&ctx->job, &sh_veu_jobs);
+}
+
+/* 4.12 fixed point scale factor and clip size for one direction */
+static u32 sh_veu_scale(unsigned int size_in, unsigned int size_out)
+{
+	u32 fixpoint, mant = 0, frac = 0;
+
+	if (size_in != size_out) {
+		fixpoint = (4096 * size_in) / size_out;
+		mant = fixpoint / 4096;
+		frac = fixpoint - mant * 4096;
+
+		/* the fraction has a resolution of 1/512 */
+		if (frac & 0x07) {
+			frac &= ~0x07;
+			if (size_out > size_in)
+				frac -= 8;
+			else
+				frac += 8;
+		}
+	}
+
+	return (mant << 12) | frac;
+}
+
+/* Called under sh_veu_lock */
+static void sh_veu_run(struct sh_veu_dev *veu, struct sh_veu_ctx *ctx)
+{
+	struct sh_veu_vfmt *src = &ctx->src;
+	struct sh_veu_vfmt *dst = &ctx->dst;
+	struct videobuf_buffer *src_buf, *dst_buf;
+	dma_addr_t src_addr, dst_addr;
+	u32 trcr;
+
+	src_buf = list_first_entry(&ctx->src_list, struct videobuf_buffer,
+				   queue);
+	dst_buf = list_first_entry(&ctx->dst_list, struct videobuf_buffer,
+				   queue);
+	list_del_init(&src_buf->queue);
+	list_del_init(&dst_buf->queue);
+	src_buf->state = VIDEOBUF_ACTIVE;
+	dst_buf->state = VIDEOBUF_ACTIVE;
+
+	veu->ctx = ctx;
+	veu->src_buf = src_buf;
+	veu->dst_buf = dst_buf;
+
+	/* the unit may have run another context before, program it all */
+	trcr = src->fmt->trcr_src | dst->fmt->trcr_dst | VEU_TRCR_BT601;
+	if (src->fmt->yuv != dst->fmt->yuv)
+		trcr |= VEU_TRCR_TE | (src->fmt->yuv ? 0 : VEU_TRCR_RY_SRC_RGB);
+
+	sh_veu_write(veu, VEU_SWR, src->bytesperline);
+	sh_veu_write(veu, VEU_SSR, (src->height << 16) | src->width);
+	sh_veu_write(veu, VEU_BSSR, 0); /* no bundle mode */
+	sh_veu_write(veu, VEU_EDWR, dst->bytesperline);
+	sh_veu_write(veu, VEU_TRCR, trcr);
+	sh_veu_write(veu, VEU_RFCR,
+		     (sh_veu_scale(src->height, dst->height) << 16) |
+		     sh_veu_scale(src->width, dst->width));
+	sh_veu_write(veu, VEU_RFSR, (dst->height << 16) | dst->width);
+	sh_veu_write(veu, VEU_ENHR, 0);
+	sh_veu_write(veu, VEU_FMCR, 0);
+	sh_veu_write(veu, VEU_APCR, 0);
+	sh_veu_write(veu, VEU_ECCR, 0);
+	sh_veu_write(veu, VEU_AFXR, 0);
+	sh_veu_write(veu, VEU_SWPR, VEU_SWPR_MAGIC);
+
+	src_addr = videobuf_to_dma_contig(src_buf);
+	dst_addr = videobuf_to_dma_contig(dst_buf);
+
+	sh_veu_write(veu, VEU_SAYR, src_addr);
+	sh_veu_write(veu, VEU_SACR, src_addr + src->bytesperline * src->height);
+	sh_veu_write(veu, VEU_DAYR, dst_addr);
+	sh_veu_write(veu, VEU_DACR, dst_addr + dst->bytesperline * dst->height);
+
+	sh_veu_write(veu, VEU_EIER, VEU_EIER_END);
+	sh_veu_write(veu, VEU_STR, VEU_STR_START);
+
+	mod_timer(&veu->watchdog, jiffies + VEU_TIMEOUT);
+}
+
+/*
+ * Hand out pending jobs to idle units. Called under sh_veu_lock.
+ * Frames of one context may run on both units at the same time,
+ * DQBUF still returns them in QBUF order.
+ */
+static void sh_veu_schedule(void)
+{
+	struct sh_veu_dev *veu;
+	struct sh_veu_ctx *ctx;
+
+	list_for_each_entry(veu, &sh_veu_units, list) {
+		if (veu->ctx)
+			continue;
+
+		/* STREAMOFF may have emptied a context after it was queued */
+		ctx = NULL;
+		while (!ctx && !list_empty(&sh_veu_jobs)) {
+			ctx = list_first_entry(&sh_veu_jobs, struct sh_veu_ctx,
+					       job);
+			list_del_init(&ctx->job);
+			if (list_empty(&ctx->src_list) ||
+			    list_empty(&ctx->dst_list))
+				ctx = NULL;
+		}
+
+		if (!ctx)
+			return;
+
+		sh_veu_run(veu, ctx);
+		sh_veu_ctx_ready(ctx);
+	}
+}
+
+static irqreturn_t sh_veu_irq(int irq, void *data)
+{
+	struct sh_veu_dev *veu = data;
+	struct videobuf_buffer *src_buf, *dst_buf;
+	u32 status = sh_veu_read(veu, VEU_EVTR);
+
+	if (!(status & VEU_EIER_END))
+		return IRQ_NONE;
+
+	sh_veu_write(veu, VEU_EIER, 0);
+	sh_veu_write(veu, VEU_STR, 0);
+	/* write 0 to clear */
+	sh_veu_write(veu, VEU_EVTR, status & ~VEU_EIER_END);
+
+	spin_lock(&sh_veu_lock);
+
+	src_buf = veu->src_buf;
+	dst_buf = veu->dst_buf;
+	if (veu->ctx) {
+		del_timer(&veu->watchdog);
+
+		do_gettimeofday(&dst_buf->ts);
+		src_buf->ts = dst_buf->ts;
+		dst_buf->field_count = src_buf->field_count;
+
+		src_buf->state = VIDEOBUF_DONE;
+		dst_buf->state = VIDEOBUF_DONE;
+		wake_up(&src_buf->done);
+		wake_up(&dst_buf->done);
+
+		veu->ctx = NULL;
+		veu->src_buf = NULL;
+		veu->dst_buf = NULL;
+	}
+
+	sh_veu_schedule();
+
+	spin_unlock(&sh_veu_lock);
+
+	return IRQ_HANDLED;
+}
+
+/*
+ * The job didn't raise END in time. Reset the unit and fail both buffers,
+ * so that DQBUF and free_buffer() don't wait for it forever.
+ */
+static void sh_veu_watchdog(unsigned long data)
+{
+	struct sh_veu_dev *veu = (struct sh_veu_dev *)data;
+	unsigned long flags;
+
+	spin_lock_irqsave(&sh_veu_lock, flags);
+
+	if (veu->ctx) {
+		dev_warn(veu->v4l2_dev.dev, "job timed out, resetting\n");
+
+		sh_veu_write(veu, VEU_EIER, 0);
+		sh_veu_write(veu, VEU_STR, 0);
+		sh_veu_write(veu, VEU_EVTR, 0);
+		sh_veu_write(veu, VEU_BSRR, VEU_BSRR_RESET);
+
+		veu->src_buf->state = VIDEOBUF_ERROR;
+		veu->dst_buf->state = VIDEOBUF_ERROR;
+		wake_up(&veu->src_buf->done);
+		wake_up(&veu->dst_buf->done);
+
+		veu->ctx = NULL;
+		veu->src_buf = NULL;
+		veu->dst_buf = NULL;
+
+		sh_veu_schedule();
+	}
+
+	spin_unlock_irqrestore(&sh_veu_lock, flags);
+}
+
+/************************************************************************
+ * videobuf
+ ************************************************************************/
+
+static struct sh_veu_vfmt *sh_veu_get_vfmt(struct sh_veu_ctx *ctx,
+					   enum v4l2_buf_type type)
+{
+	switch (type) {
+	case V4L2_BUF_TYPE_VIDEO_OUTPUT:
+		return &ctx->src;
+	case V4L2_BUF_TYPE_VIDEO_CAPTURE:
+		return &ctx->dst;
+	default:
+		return NULL;
+	}
+}
+
+static struct videobuf_queue *sh_veu_get_vq(struct sh_veu_ctx *ctx,
+					    enum v4l2_buf_type type)
+{
+	switch (type) {
+	case V4L2_BUF_TYPE_VIDEO_OUTPUT:
+		return &ctx->src_vq;
+	case V4L2_BUF_TYPE_VIDEO_CAPTURE:
+		return &ctx->dst_vq;
+	default:
+		return NULL;
+	}
+}
+
+static int sh_veu_videobuf_setup(struct videobuf_queue *vq,
+				 unsigned int *count, unsigned int *size)
+{
+	struct sh_veu_ctx *ctx = vq->priv_data;
+	struct sh_veu_vfmt *vfmt = sh_veu_get_vfmt(ctx, vq->type);
+
+	*size = vfmt->sizeimage;
+
+	if (0 == *count)
+		*count = 2;
+
+	if (ctx->veu->video_limit) {
+		while (*count && PAGE_ALIGN(*size) * *count >
+		       ctx->veu->video_limit)
+			(*count)--;
+	}
+
+	return 0;
+}
+
+static void free_buffer(struct videobuf_queue *vq, struct videobuf_buffer *vb)
+{
+	BUG_ON(in_interrupt());
+
+	/* a job may still be using it on either unit */
+	videobuf_waiton(vb, 0, 0);
+	videobuf_dma_contig_free(vq, vb);
+	vb->state = VIDEOBUF_NEEDS_INIT;
+}
+
+static int sh_veu_videobuf_prepare(struct videobuf_queue *vq,
+				   struct videobuf_buffer *vb,
+				   enum v4l2_field field)
+{
+	struct sh_veu_ctx *ctx = vq->priv_data;
+	struct sh_veu_vfmt *vfmt = sh_veu_get_vfmt(ctx, vq->type);
+	int ret;
+
+	if (vb->width	!= vfmt->width ||
+	    vb->height	!= vfmt->height ||
+	    vb->field	!= field) {
+		vb->width	= vfmt->width;
+		vb->height	= vfmt->height;
+		vb->field	= field;
+		vb->state	= VIDEOBUF_NEEDS_INIT;
+	}
+
+	vb->size = vfmt->sizeimage;
+	if (0 != vb->baddr && vb->bsize < vb->size)
+		return -EINVAL;
+
+	if (vb->state == VIDEOBUF_NEEDS_INIT) {
+		/* USERPTR must be physically contiguous, e.g. another UIO map */
+		ret = videobuf_iolock(vq, vb, NULL);
+		if (ret) {
+			free_buffer(vq, vb);
+			return ret;
+		}
+		vb->state = VIDEOBUF_PREPARED;
+	}
+
+	return 0;
+}
+
+/* Called under spin_lock_irqsave(&sh_veu_lock, ...) */
+static void sh_veu_videobuf_queue(struct videobuf_queue *vq,
+				  struct videobuf_buffer *vb)
+{
+	struct sh_veu_ctx *ctx = vq->priv_data;
+
+	vb->state = VIDEOBUF_QUEUED;
+	if (vq == &ctx->src_vq)
+		list_add_tail(&vb->queue, &ctx->src_list);
+	else
+		list_add_tail(&vb->queue, &ctx->dst_list);
+
+	sh_veu_ctx_ready(ctx);
+	sh_veu_schedule();
+}
+
+static void sh_veu_videobuf_release(struct videobuf_queue *vq,
+				    struct videobuf_buffer *vb)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&sh_veu_lock, flags);
+
+	if (vb->state == VIDEOBUF_QUEUED && !list_empty(&vb->queue)) {
+		vb->state = VIDEOBUF_ERROR;
+		list_del_init(&vb->queue);
+	}
+
+	spin_unlock_irqrestore(&sh_veu_lock, flags);
+
+	free_buffer(vq, vb);
+}
+
+static struct videobuf_queue_ops sh_veu_videobuf_ops = {
+	.buf_setup	= sh_veu_videobuf_setup,
+	.buf_prepare	= sh_veu_videobuf_prepare,
+	.buf_queue	= sh_veu_videobuf_queue,
+	.buf_release	= sh_veu_videobuf_release,
+};
+
+/************************************************************************
+ * ioctls
+ ************************************************************************/
+
+static int sh_veu_querycap(struct file *file, void *priv,
+			   struct v4l2_capability *cap)
+{
+	struct sh_veu_ctx *ctx = priv;
+
+	strlcpy(cap->driver, "sh_veu", sizeof(cap->driver));
+	strlcpy(cap->card, "SuperH Mobile VEU", sizeof(cap->card));
+	snprintf(cap->bus_info, sizeof(cap->bus_info), "platform:%s",
+		 dev_name(ctx->veu->v4l2_dev.dev));
+	cap->version = KERNEL_VERSION(0, 0, 1);
+	cap->capabilities = V4L2_CAP_VIDEO_CAPTURE | V4L2_CAP_VIDEO_OUTPUT |
+		V4L2_CAP_STREAMING;
+
+	return 0;
+}
+
+static int sh_veu_enum_fmt(struct file *file, void *priv,
+			   struct v4l2_fmtdesc *f)
+{
+	if (f->index >= ARRAY_SIZE(sh_veu_fmts))
+		return -EINVAL;
+
+	strlcpy(f->description, sh_veu_fmts[f->index].name,
+		sizeof(f->description));
+	f->pixelformat = sh_veu_fmts[f->index].fourcc;
+
+	return 0;
+}
+
+static int sh_veu_g_fmt(struct file *file, void *priv, struct v4l2_format *f)
+{
+	struct sh_veu_vfmt *vfmt = sh_veu_get_vfmt(priv, f->type);
+	struct v4l2_pix_format *pix = &f->fmt.pix;
+
+	if (!vfmt)
+		return -EINVAL;
+
+	pix->width		= vfmt->width;
+	pix->height		= vfmt->height;
+	pix->field		= V4L2_FIELD_NONE;
+	pix->pixelformat	= vfmt->fmt->fourcc;
+	pix->bytesperline	= vfmt->bytesperline;
+	pix->sizeimage		= vfmt->sizeimage;
+	pix->colorspace		= vfmt->fmt->yuv ? V4L2_COLORSPACE_SMPTE170M :
+		V4L2_COLORSPACE_SRGB;
+
+	return 0;
+}
+
+static const struct sh_veu_fmt *sh_veu_find_fmt(u32 fourcc)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(sh_veu_fmts); i++)
+		if (sh_veu_fmts[i].fourcc == fourcc)
+			return sh_veu_fmts + i;
+
+	return NULL;
+}
+
+static void sh_veu_fill_vfmt(struct sh_veu_vfmt *vfmt,
+			     struct v4l2_pix_format *pix)
+{
+	const struct sh_veu_fmt *fmt = sh_veu_find_fmt(pix->pixelformat);
+
+	if (!fmt)
+		fmt = &sh_veu_fmts[0];
+
+	/* widths multiple of 4, even heights for the 4:2:0 chroma plane */
+	v4l_bound_align_image(&pix->width, VEU_MIN_SIZE, VEU_MAX_WIDTH, 2,
+			      &pix->height, VEU_MIN_SIZE, VEU_MAX_HEIGHT, 1, 0);
+
+	vfmt->fmt		= fmt;
+	vfmt->width		= pix->width;
+	vfmt->height		= pix->height;
+	vfmt->bytesperline	= pix->width * fmt->ydepth / 8;
+	vfmt->sizeimage		= pix->width * pix->height * fmt->depth / 8;
+}
+
+static int sh_veu_try_fmt(struct file *file, void *priv,
+			  struct v4l2_format *f)
+{
+	struct sh_veu_vfmt vfmt;
+
+	if (!sh_veu_get_vfmt(priv, f->type))
+		return -EINVAL;
+
+	sh_veu_fill_vfmt(&vfmt, &f->fmt.pix);
+
+	f->fmt.pix.field	= V4L2_FIELD_NONE;
+	f->fmt.pix.pixelformat	= vfmt.fmt->fourcc;
+	f->fmt.pix.bytesperline	= vfmt.bytesperline;
+	f->fmt.pix.sizeimage	= vfmt.sizeimage;
+	f->fmt.pix.colorspace	= vfmt.fmt->yuv ? V4L2_COLORSPACE_SMPTE170M :
+		V4L2_COLORSPACE_SRGB;
+
+	return 0;
+}
+
+static int sh_veu_s_fmt(struct file *file, void *priv, struct v4l2_format *f)
+{
+	struct sh_veu_vfmt *vfmt = sh_veu_get_vfmt(priv, f->type);
+	struct videobuf_queue *vq = sh_veu_get_vq(priv, f->type);
+	int ret;
+
+	if (!vfmt)
+		return -EINVAL;
+
+	mutex_lock(&vq->vb_lock);
+
+	if (videobuf_queue_is_busy(vq)) {
+		ret = -EBUSY;
+		goto out;
+	}
+
+	ret = sh_veu_try_fmt(file, priv, f);
+	if (!ret)
+		sh_veu_fill_vfmt(vfmt, &f->fmt.pix);
+out:
+	mutex_unlock(&vq->vb_lock);
+
+	return ret;
+}
+
+static int sh_veu_reqbufs(struct file *file, void *priv,
+			  struct v4l2_requestbuffers *p)
+{
+	struct videobuf_queue *vq = sh_veu_get_vq(priv, p->type);
+
+	if (!vq)
+		return -EINVAL;
+
+	return videobuf_reqbufs(vq, p);
+}
+
+/* CAPTURE and OUTPUT buffers share one mmap() offset space */
+static void sh_veu_fix_offset(struct sh_veu_ctx *ctx, struct v4l2_buffer *p)
+{
+	if (p->memory == V4L2_MEMORY_MMAP &&
+	    p->type == V4L2_BUF_TYPE_VIDEO_CAPTURE)
+		p->m.offset += SH_VEU_DST_OFF;
+}
+
+static int sh_veu_querybuf(struct file *file, void *priv,
+			   struct v4l2_buffer *p)
+{
+	struct videobuf_queue *vq = sh_veu_get_vq(priv, p->type);
+	int ret;
+
+	if (!vq)
+		return -EINVAL;
+
+	ret = videobuf_querybuf(vq, p);
+	if (!ret)
+		sh_veu_fix_offset(priv, p);
+
+	return ret;
+}
+
+static int sh_veu_qbuf(struct file *file, void *priv, struct v4l2_buffer *p)
+{
+	struct videobuf_queue *vq = sh_veu_get_vq(priv, p->type);
+
+	if (!vq)
+		return -EINVAL;
+
+	return videobuf_qbuf(vq, p);
+}
+
+static int sh_veu_dqbuf(struct file *file, void *priv, struct v4l2_buffer *p)
+{
+	struct videobuf_queue *vq = sh_veu_get_vq(priv, p->type);
+	int ret;
+
+	if (!vq)
+		return -EINVAL;
+
+	ret = videobuf_dqbuf(vq, p, file->f_flags & O_NONBLOCK);
+	if (!ret)
+		sh_veu_fix_offset(priv, p);
+
+	return ret;
+}
+
+static int sh_veu_streamon(struct file *file, void *priv,
+			   enum v4l2_buf_type type)
+{
+	struct sh_veu_ctx *ctx = priv;
+	struct videobuf_queue *vq = sh_veu_get_vq(ctx, type);
+
+	if (!vq)
+		return -EINVAL;
+
+	/* the resizer scales down to 1/16 and up to 8 times */
+	if (ctx->dst.width > ctx->src.width * 8 ||
+	    ctx->dst.height > ctx->src.height * 8 ||
+	    ctx->dst.width * 16 < ctx->src.width ||
+	    ctx->dst.height * 16 < ctx->src.height)
+		return -EINVAL;
+
+	return videobuf_streamon(vq);
+}
+
+static int sh_veu_streamoff(struct file *file, void *priv,
+			    enum v4l2_buf_type type)
+{
+	struct videobuf_queue *vq = sh_veu_get_vq(priv, type);
+
+	if (!vq)
+		return -EINVAL;
+
+	return videobuf_streamoff(vq);
+}
+
+static const struct v4l2_ioctl_ops sh_veu_ioctl_ops = {
+	.vidioc_querycap		= sh_veu_querycap,
+
+	.vidioc_enum_fmt_vid_cap	= sh_veu_enum_fmt,
+	.vidioc_g_fmt_vid_cap		= sh_veu_g_fmt,
+	.vidioc_try_fmt_vid_cap		= sh_veu_try_fmt,
+	.vidioc_s_fmt_vid_cap		= sh_veu_s_fmt,
+
+	.vidioc_enum_fmt_vid_out	= sh_veu_enum_fmt,
+	.vidioc_g_fmt_vid_out		= sh_veu_g_fmt,
+	.vidioc_try_fmt_vid_out		= sh_veu_try_fmt,
+	.vidioc_s_fmt_vid_out		= sh_veu_s_fmt,
+
+	.vidioc_reqbufs			= sh_veu_reqbufs,
+	.vidioc_querybuf		= sh_veu_querybuf,
+	.vidioc_qbuf			= sh_veu_qbuf,
+	.vidioc_dqbuf			= sh_veu_dqbuf,
+
+	.vidioc_streamon		= sh_veu_streamon,
+	.vidioc_streamoff		= sh_veu_streamoff,
+};
+
+/************************************************************************
+ * file operations
+ ************************************************************************/
+
+static int sh_veu_open(struct file *file)
+{
+	struct sh_veu_dev *veu = video_drvdata(file);
+	struct sh_veu_dev *unit;
+	struct sh_veu_ctx *ctx;
+	struct v4l2_pix_format pix = {
+		.width		= 640,
+		.height		= 480,
+		.pixelformat	= V4L2_PIX_FMT_NV12,
+	};
+
+	ctx = kzalloc(sizeof(*ctx), GFP_KERNEL);
+	if (!ctx)
+		return -ENOMEM;
+
+	ctx->veu = veu;
+	INIT_LIST_HEAD(&ctx->src_list);
+	INIT_LIST_HEAD(&ctx->dst_list);
+	INIT_LIST_HEAD(&ctx->job);
+
+	sh_veu_fill_vfmt(&ctx->src, &pix);
+	pix.pixelformat = V4L2_PIX_FMT_RGB565;
+	sh_veu_fill_vfmt(&ctx->dst, &pix);
+
+	videobuf_queue_dma_contig_init(&ctx->src_vq, &sh_veu_videobuf_ops,
+				       veu->v4l2_dev.dev, &sh_veu_lock,
+				       V4L2_BUF_TYPE_VIDEO_OUTPUT,
+				       V4L2_FIELD_NONE,
+				       sizeof(struct videobuf_buffer), ctx);
+	videobuf_queue_dma_contig_init(&ctx->dst_vq, &sh_veu_videobuf_ops,
+				       veu->v4l2_dev.dev, &sh_veu_lock,
+				       V4L2_BUF_TYPE_VIDEO_CAPTURE,
+				       V4L2_FIELD_NONE,
+				       sizeof(struct videobuf_buffer), ctx);
+
+	/* jobs run on any unit, keep them all powered while in use */
+	mutex_lock(&sh_veu_mutex);
+	if (!sh_veu_users++)
+		list_for_each_entry(unit, &sh_veu_units, list)
+			pm_runtime_get_sync(unit->v4l2_dev.dev);
+	mutex_unlock(&sh_veu_mutex);
+
+	file->private_data = ctx;
+
+	return 0;
+}
+
+static int sh_veu_release(struct file *file)
+{
+	struct sh_veu_ctx *ctx = file->private_data;
+	struct sh_veu_dev *unit;
+	unsigned long flags;
+
+	/* waits for jobs still running on the hardware */
+	videobuf_stop(&ctx->src_vq);
+	videobuf_stop(&ctx->dst_vq);
+
+	spin_lock_irqsave(&sh_veu_lock, flags);
+	list_del_init(&ctx->job);
+	spin_unlock_irqrestore(&sh_veu_lock, flags);
+
+	videobuf_mmap_free(&ctx->src_vq);
+	videobuf_mmap_free(&ctx->dst_vq);
+
+	mutex_lock(&sh_veu_mutex);
+	if (!--sh_veu_users)
+		list_for_each_entry(unit, &sh_veu_units, list)
+			pm_runtime_put_sync(unit->v4l2_dev.dev);
+	mutex_unlock(&sh_veu_mutex);
+
+	kfree(ctx);
+
+	return 0;
+}
+
+static unsigned int sh_veu_poll_vq(struct file *file, struct videobuf_queue *vq,
+				   poll_table *wait, unsigned int ready)
+{
+	struct videobuf_buffer *vb = NULL;
+	unsigned int mask = 0;
+
+	mutex_lock(&vq->vb_lock);
+
+	if (!vq->streaming)
+		mask = POLLERR;
+	else if (!list_empty(&vq->stream))
+		vb = list_first_entry(&vq->stream, struct videobuf_buffer,
+				      stream);
+
+	if (vb) {
+		poll_wait(file, &vb->done, wait);
+		if (vb->state == VIDEOBUF_DONE || vb->state == VIDEOBUF_ERROR)
+			mask = ready;
+	}
+
+	mutex_unlock(&vq->vb_lock);
+
+	return mask;
+}
+
+static unsigned int sh_veu_poll(struct file *file, poll_table *wait)
+{
+	struct sh_veu_ctx *ctx = file->private_data;
+
+	return sh_veu_poll_vq(file, &ctx->src_vq, wait, POLLOUT | POLLWRNORM) |
+		sh_veu_poll_vq(file, &ctx->dst_vq, wait, POLLIN | POLLRDNORM);
+}
+
+static int sh_veu_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct sh_veu_ctx *ctx = file->private_data;
+
+	if (vma->vm_pgoff >= SH_VEU_DST_OFF >> PAGE_SHIFT) {
+		vma->vm_pgoff -= SH_VEU_DST_OFF >> PAGE_SHIFT;
+		return videobuf_mmap_mapper(&ctx->dst_vq, vma);
+	}
+
+	return videobuf_mmap_mapper(&ctx->src_vq, vma);
+}
+
+static const struct v4l2_file_operations sh_veu_fops = {
+	.owner		= THIS_MODULE,
+	.open		= sh_veu_open,
+	.release	= sh_veu_release,
+	.poll		= sh_veu_poll,
+	.ioctl		= video_ioctl2,
+	.mmap		= sh_veu_mmap,
+};
+
+/************************************************************************
+ * platform driver
+ ************************************************************************/
+
+static int __devinit sh_veu_probe(struct platform_device *pdev)
+{
+	struct sh_veu_dev *veu;
+	struct video_device *vdev;
+	struct resource *res;
+	unsigned long flags;
+	unsigned int irq;
+	int err;
+
+	res = platform_get_resource(pdev, IORESOURCE_MEM, 0);
+	irq = platform_get_irq(pdev, 0);
+	if (!res || (int)irq <= 0) {
+		dev_err(&pdev->dev, "Not enough VEU platform resources.\n");
+		err = -ENODEV;
+		goto exit;
+	}
+
+	veu = kzalloc(sizeof(*veu), GFP_KERNEL);
+	if (!veu) {
+		dev_err(&pdev->dev, "Could not allocate veu\n");
+		err = -ENOMEM;
+		goto exit;
+	}
+
+	veu->base = ioremap_nocache(res->start, resource_size(res));
+	if (!veu->base) {
+		err = -ENXIO;
+		dev_err(&pdev->dev, "Unable to ioremap VEU registers.\n");
+		goto exit_kfree;
+	}
+
+	veu->irq = irq;
+	setup_timer(&veu->watchdog, sh_veu_watchdog, (unsigned long)veu);
+
+	res = platform_get_resource(pdev, IORESOURCE_MEM, 1);
+	if (res) {
+		err = dma_declare_coherent_memory(&pdev->dev, res->start,
+						  res->start,
+						  resource_size(res),
+						  DMA_MEMORY_MAP |
+						  DMA_MEMORY_EXCLUSIVE);
+		if (!err) {
+			dev_err(&pdev->dev, "Unable to declare VEU memory.\n");
+			err = -ENXIO;
+			goto exit_iounmap;
+		}
+
+		veu->video_limit = resource_size(res);
+	}
+
+	err = request_irq(veu->irq, sh_veu_irq, IRQF_DISABLED,
+			  dev_name(&pdev->dev), veu);
+	if (err) {
+		dev_err(&pdev->dev, "Unable to register VEU interrupt.\n");
+		goto exit_release_mem;
+	}
+
+	pm_runtime_enable(&pdev->dev);
+	pm_runtime_resume(&pdev->dev);
+
+	pm_runtime_get_sync(&pdev->dev);
+	sh_veu_write(veu, VEU_BSRR, VEU_BSRR_RESET);
+	pm_runtime_put_sync(&pdev->dev);
+
+	err = v4l2_device_register(&pdev->dev, &veu->v4l2_dev);
+	if (err)
+		goto exit_free_irq;
+
+	vdev = video_device_alloc();
+	if (!vdev) {
+		err = -ENOMEM;
+		goto exit_v4l2_unregister;
+	}
+
+	strlcpy(vdev->name, dev_name(&pdev->dev), sizeof(vdev->name));
+	vdev->fops	= &sh_veu_fops;
+	vdev->ioctl_ops	= &sh_veu_ioctl_ops;
+	vdev->release	= video_device_release;
+	vdev->v4l2_dev	= &veu->v4l2_dev;
+	video_set_drvdata(vdev, veu);
+	veu->vdev = vdev;
+
+	mutex_lock(&sh_veu_mutex);
+	if (sh_veu_users)
+		pm_runtime_get_sync(&pdev->dev);
+	spin_lock_irqsave(&sh_veu_lock, flags);
+	list_add_tail(&veu->list, &sh_veu_units);
+	sh_veu_schedule();
+	spin_unlock_irqrestore(&sh_veu_lock, flags);
+	mutex_unlock(&sh_veu_mutex);
+
+	err = video_register_device(vdev, VFL_TYPE_GRABBER, -1);
+	if (err)
+		goto exit_unlist;
+
+	platform_set_drvdata(pdev, veu);
+
+	dev_info(&pdev->dev, "registered as /dev/video%d\n", vdev->num);
+
+	return 0;
+
+exit_unlist:
+	mutex_lock(&sh_veu_mutex);
+	spin_lock_irqsave(&sh_veu_lock, flags);
+	list_del(&veu->list);
+	spin_unlock_irqrestore(&sh_veu_lock, flags);
+	if (sh_veu_users)
+		pm_runtime_put_sync(&pdev->dev);
+	mutex_unlock(&sh_veu_mutex);
+	del_timer_sync(&veu->watchdog);
+	video_device_release(vdev);
+exit_v4l2_unregister:
+	v4l2_device_unregister(&veu->v4l2_dev);
+exit_free_irq:
+	pm_runtime_disable(&pdev->dev);
+	free_irq(veu->irq, veu);
+exit_release_mem:
+	if (platform_get_resource(pdev, IORESOURCE_MEM, 1))
+		dma_release_declared_memory(&pdev->dev);
+exit_iounmap:
+	iounmap(veu->base);
+exit_kfree:
+	kfree(veu);
+exit:
+	return err;
+}
+
+static int __devexit sh_veu_remove(struct platform_device *pdev)
+{
+	struct sh_veu_dev *veu = platform_get_drvdata(pdev);
+	unsigned long flags;
+
+	video_unregister_device(veu->vdev);
+
+	mutex_lock(&sh_veu_mutex);
+	spin_lock_irqsave(&sh_veu_lock, flags);
+	list_del(&veu->list);
+	spin_unlock_irqrestore(&sh_veu_lock, flags);
+	if (sh_veu_users)
+		pm_runtime_put_sync(&pdev->dev);
+	mutex_unlock(&sh_veu_mutex);
+
+	del_timer_sync(&veu->watchdog);
+	v4l2_device_unregister(&veu->v4l2_dev);
+	pm_runtime_disable(&pdev->dev);
+	free_irq(veu->irq, veu);
+	if (platform_get_resource(pdev, IORESOURCE_MEM, 1))
+		dma_release_declared_memory(&pdev->dev);
+	iounmap(veu->base);
+	kfree(veu);
+
+	return 0;
+}
+
+static int sh_veu_runtime_nop(struct device *dev)
+{
+	/* Runtime PM callback shared between ->runtime_suspend()
+	 * and ->runtime_resume(). Simply returns success.
+	 *
+	 * This driver programs all registers for every job
+	 * anyway so there is no need to save and restore
+	 * registers here.
+	 */
+	return 0;
+}
+
+static const struct dev_pm_ops sh_veu_dev_pm_ops = {
+	.runtime_suspend = sh_veu_runtime_nop,
+	.runtime_resume = sh_veu_runtime_nop,
+};
+
+static struct platform_driver sh_veu_driver = {
+	.driver		= {
+		.name	= "sh_veu",
+		.pm	= &sh_veu_dev_pm_ops,
+	},
+	.probe		= sh_veu_probe,
+	.remove		= __devexit_p(sh_veu_remove),
+};
+
+static int __init sh_veu_init(void)
+{
+	return platform_driver_register(&sh_veu_driver);
+}
+
+static void __exit sh_veu_exit(void)
+{
+	platform_driver_unregister(&sh_veu_driver);
+}
+
+module_init(sh_veu_init);
+module_exit(sh_veu_exit);
+
+MODULE_DESCRIPTION("SuperH Mobile VEU mem-to-mem driver");
+MODULE_LICENSE("GPL v2");
+MODULE_ALIAS("platform:sh_veu");
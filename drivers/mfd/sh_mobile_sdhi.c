@@ -26,10 +26,15 @@
 #include <linux/mfd/tmio.h>
 #include <linux/mfd/sh_mobile_sdhi.h>
 
+#include <asm/dma-sh.h>
+
 struct sh_mobile_sdhi {
 	struct clk *clk;
 	struct tmio_mmc_data mmc_data;
 	struct mfd_cell cell_mmc;
+	struct sh_dmae_slave param_tx;
+	struct sh_dmae_slave param_rx;
+	struct tmio_mmc_dma dma_priv;
 };
 
 static struct resource sh_mobile_sdhi_resources[] = {
@@ -62,6 +67,7 @@ static void sh_mobile_sdhi_set_pwr(struct platform_device *tmio, int state)
 
 static int __init sh_mobile_sdhi_probe(struct platform_device *pdev)
 {
+	struct sh_mobile_sdhi_info *p = pdev->dev.platform_data;
 	struct sh_mobile_sdhi *priv;
 	struct resource *mem;
 	char clk_name[8];
@@ -99,6 +105,14 @@ static int __init sh_mobile_sdhi_probe(struct platform_device *pdev)
 	*(unsigned int *)&priv->mmc_data.hclk = clk_get_rate(priv->clk);
 	priv->mmc_data.set_pwr = sh_mobile_sdhi_set_pwr;
 
+	if (p && p->dma_slave_tx > 0 && p->dma_slave_rx > 0) {
+		priv->param_tx.slave_id = p->dma_slave_tx;
+		priv->param_rx.slave_id = p->dma_slave_rx;
+		priv->dma_priv.chan_priv_tx = &priv->param_tx;
+		priv->dma_priv.chan_priv_rx = &priv->param_rx;
+		priv->mmc_data.dma = &priv->dma_priv;
+	}
+
 	memcpy(&priv->cell_mmc, &sh_mobile_sdhi_cell, sizeof(priv->cell_mmc));
 	priv->cell_mmc.driver_data = &priv->mmc_data;
 	priv->cell_mmc.platform_data = &priv->cell_mmc;
@@ -198,7 +198,7 @@ static inline void tmio_mmc_pio_irq(struct tmio_mmc_host *host)
 	return;
 }
 
-static inline void tmio_mmc_data_irq(struct tmio_mmc_host *host)
+static void tmio_mmc_do_data_irq(struct tmio_mmc_host *host)
 {
 	struct mmc_data *data = host->data;
 	struct mmc_command *stop;
@@ -242,6 +242,26 @@ static inline void tmio_mmc_data_irq(struct tmio_mmc_host *host)
 	tmio_mmc_finish_request(host);
 }
 
+static inline void tmio_mmc_data_irq(struct tmio_mmc_host *host)
+{
+	if (host->data_chan) {
+		/*
+		 * The DMAC has emptied or filled the buffer already, but a
+		 * write may still keep the card busy, in which case another
+		 * DATAEND follows.
+		 */
+		if (host->data->flags & MMC_DATA_WRITE &&
+		    sd_ctrl_read32(host, CTL_STATUS) & TMIO_STAT_CMD_BUSY)
+			return;
+
+		disable_mmc_irqs(host, TMIO_STAT_DATAEND);
+		tasklet_schedule(&host->dma_complete);
+		return;
+	}
+
+	tmio_mmc_do_data_irq(host);
+}
+
 static inline void tmio_mmc_cmd_irq(struct tmio_mmc_host *host,
 	unsigned int stat)
 {
@@ -282,10 +302,18 @@ static inline void tmio_mmc_cmd_irq(struct tmio_mmc_host *host,
 	 * If theres no data or we encountered an error, finish now.
 	 */
 	if (host->data && !cmd->error) {
-		if (host->data->flags & MMC_DATA_READ)
+		if (host->data_chan) {
+			/* Rx DMA is already waiting, Tx starts now */
+			if (host->data->flags & MMC_DATA_WRITE)
+				tasklet_schedule(&host->dma_issue);
+		} else if (host->data->flags & MMC_DATA_READ) {
 			enable_mmc_irqs(host, TMIO_MASK_READOP);
-		else
+		} else {
 			enable_mmc_irqs(host, TMIO_MASK_WRITEOP);
+		}
+	} else if (host->data_chan) {
+		/* The DMA transfer has to be torn down first */
+		tasklet_schedule(&host->dma_complete);
 	} else {
 		tmio_mmc_finish_request(host);
 	}
@@ -363,6 +391,194 @@ out:
 	return IRQ_HANDLED;
 }
 
+#ifdef CONFIG_TMIO_MMC_DMA
+static void tmio_mmc_enable_dma(struct tmio_mmc_host *host, bool enable)
+{
+	/* SDHI specific, switches the data port between PIO and DMA */
+	sd_ctrl_write16(host, CTL_DMA_ENABLE, enable ? 2 : 0);
+}
+
+/* Called by the DMA engine once the last chunk has been moved */
+static void tmio_mmc_dma_callback(void *arg)
+{
+	struct tmio_mmc_host *host = arg;
+	unsigned long flags;
+
+	/* Don't race with the read-modify-write in tmio_mmc_irq() */
+	local_irq_save(flags);
+	enable_mmc_irqs(host, TMIO_STAT_DATAEND);
+	local_irq_restore(flags);
+}
+
+/*
+ * Try to set up a DMA transfer for the request. host->data_chan stays
+ * NULL if the transfer is too short or the buffers are unsuitable, and
+ * the data is moved by tmio_mmc_pio_irq() instead.
+ */
+static void tmio_mmc_start_dma(struct tmio_mmc_host *host,
+	struct mmc_data *data)
+{
+	struct dma_async_tx_descriptor *desc;
+	enum dma_data_direction dir;
+	struct scatterlist *sg;
+	struct dma_chan *chan;
+	dma_cookie_t cookie;
+	int i, ret;
+
+	if (data->flags & MMC_DATA_READ) {
+		chan = host->chan_rx;
+		dir = DMA_FROM_DEVICE;
+	} else {
+		chan = host->chan_tx;
+		dir = DMA_TO_DEVICE;
+	}
+
+	if (!chan || data->blksz * data->blocks < TMIO_MMC_MIN_DMA_LEN)
+		return;
+
+	/* The DMAC moves 16 bits at a time */
+	for_each_sg(data->sg, sg, data->sg_len, i)
+		if ((sg->offset | sg->length) & 1)
+			return;
+
+	ret = dma_map_sg(chan->device->dev, data->sg, data->sg_len, dir);
+	if (ret <= 0)
+		return;
+
+	desc = chan->device->device_prep_slave_sg(chan, data->sg, ret, dir,
+					DMA_PREP_INTERRUPT | DMA_CTRL_ACK);
+	if (!desc)
+		goto unmap;
+
+	desc->callback = tmio_mmc_dma_callback;
+	desc->callback_param = host;
+	cookie = desc->tx_submit(desc);
+	if (cookie < 0)
+		goto unmap;
+
+	host->data_chan = chan;
+	tmio_mmc_enable_dma(host, true);
+
+	/* Reads can be started right away, the DMAC waits for the SDHI */
+	if (dir == DMA_FROM_DEVICE)
+		dma_async_issue_pending(chan);
+
+	return;
+
+unmap:
+	dma_unmap_sg(chan->device->dev, data->sg, data->sg_len, dir);
+	dev_dbg(&host->pdev->dev, "DMA setup failed, falling back to PIO\n");
+}
+
+static void tmio_mmc_issue_tasklet_fn(unsigned long arg)
+{
+	struct tmio_mmc_host *host = (struct tmio_mmc_host *)arg;
+
+	if (host->data_chan)
+		dma_async_issue_pending(host->data_chan);
+}
+
+static void tmio_mmc_complete_tasklet_fn(unsigned long arg)
+{
+	struct tmio_mmc_host *host = (struct tmio_mmc_host *)arg;
+	struct dma_chan *chan = host->data_chan;
+	struct mmc_data *data = host->data;
+	bool failed;
+
+	if (!chan || !data)
+		return;
+
+	failed = host->mrq->cmd->error || data->error;
+	if (failed)
+		chan->device->device_terminate_all(chan);
+
+	dma_unmap_sg(chan->device->dev, data->sg, data->sg_len,
+		     data->flags & MMC_DATA_READ ?
+		     DMA_FROM_DEVICE : DMA_TO_DEVICE);
+	tmio_mmc_enable_dma(host, false);
+	host->data_chan = NULL;
+
+	if (failed)
+		tmio_mmc_finish_request(host);
+	else
+		tmio_mmc_do_data_irq(host);
+}
+
+static bool tmio_mmc_filter(struct dma_chan *chan, void *arg)
+{
+	dev_dbg(chan->device->dev, "%s: slave data %p\n", __func__, arg);
+	chan->private = arg;
+	return true;
+}
+
+static void tmio_mmc_request_dma(struct tmio_mmc_host *host,
+				 struct tmio_mmc_data *pdata)
+{
+	dma_cap_mask_t mask;
+
+	host->data_chan = NULL;
+
+	/* We can only either use DMA for both Tx and Rx or not use it at all */
+	if (!pdata->dma)
+		return;
+
+	dma_cap_zero(mask);
+	dma_cap_set(DMA_SLAVE, mask);
+
+	host->chan_tx = dma_request_channel(mask, tmio_mmc_filter,
+					    pdata->dma->chan_priv_tx);
+	if (!host->chan_tx)
+		return;
+
+	host->chan_rx = dma_request_channel(mask, tmio_mmc_filter,
+					    pdata->dma->chan_priv_rx);
+	if (!host->chan_rx) {
+		dma_release_channel(host->chan_tx);
+		host->chan_tx = NULL;
+		return;
+	}
+
+	tasklet_init(&host->dma_issue, tmio_mmc_issue_tasklet_fn,
+		     (unsigned long)host);
+	tasklet_init(&host->dma_complete, tmio_mmc_complete_tasklet_fn,
+		     (unsigned long)host);
+
+	dev_info(&host->pdev->dev, "using DMA channels %s (Tx), %s (Rx)\n",
+		 dma_chan_name(host->chan_tx), dma_chan_name(host->chan_rx));
+}
+
+static void tmio_mmc_release_dma(struct tmio_mmc_host *host)
+{
+	if (host->chan_tx) {
+		tasklet_kill(&host->dma_issue);
+		tasklet_kill(&host->dma_complete);
+		dma_release_channel(host->chan_tx);
+		host->chan_tx = NULL;
+	}
+	if (host->chan_rx) {
+		dma_release_channel(host->chan_rx);
+		host->chan_rx = NULL;
+	}
+}
+#else
+static void tmio_mmc_start_dma(struct tmio_mmc_host *host,
+	struct mmc_data *data)
+{
+}
+
+static void tmio_mmc_request_dma(struct tmio_mmc_host *host,
+				 struct tmio_mmc_data *pdata)
+{
+	host->chan_tx = NULL;
+	host->chan_rx = NULL;
+	host->data_chan = NULL;
+}
+
+static void tmio_mmc_release_dma(struct tmio_mmc_host *host)
+{
+}
+#endif
+
 static int tmio_mmc_start_data(struct tmio_mmc_host *host,
 	struct mmc_data *data)
 {
@@ -383,6 +599,8 @@ static int tmio_mmc_start_data(struct tmio_mmc_host *host,
 	sd_ctrl_write16(host, CTL_SD_XFER_LEN, data->blksz);
 	sd_ctrl_write16(host, CTL_XFER_BLK_COUNT, data->blocks);
 
+	tmio_mmc_start_dma(host, data);
+
 	return 0;
 }
 
@@ -577,6 +795,9 @@ static int __devinit tmio_mmc_probe(struct platform_device *dev)
 	if (ret)
 		goto unmap_ctl;
 
+	/* See if we also get DMA */
+	tmio_mmc_request_dma(host, pdata);
+
 	mmc_add_host(mmc);
 
 	printk(KERN_INFO "%s at 0x%08lx irq %d\n", mmc_hostname(host->mmc),
@@ -604,6 +825,7 @@ static int __devexit tmio_mmc_remove(struct platform_device *dev)
 	if (mmc) {
 		struct tmio_mmc_host *host = mmc_priv(mmc);
 		mmc_remove_host(mmc);
+		tmio_mmc_release_dma(host);
 		free_irq(host->irq, host);
 		iounmap(host->ctl);
 		mmc_free_host(mmc);
@@ -24,8 +24,17 @@
 #include <linux/module.h>
 #include <linux/kernel.h>
 #include <linux/delay.h>
+#include <linux/interrupt.h>
 #include <linux/io.h>
 #include <linux/platform_device.h>
+#include <linux/dmaengine.h>
+#include <linux/dma-mapping.h>
+#include <linux/scatterlist.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/vmalloc.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
 
 #include <linux/mtd/mtd.h>
 #include <linux/mtd/nand.h>
@@ -96,6 +105,198 @@ static void wait_completion(struct sh_flctl *flctl)
 	writeb(0x0, FLTRCR(flctl));
 }
 
+/* Sleeping waits give up after this, like LOOP_TIMEOUT_MAX for polling */
+#define FLCTL_TIMEOUT	msecs_to_jiffies(100)
+
+static bool flctl_may_sleep(struct sh_flctl *flctl)
+{
+	/* mtdoops and friends write pages from atomic context */
+	return !flctl->pio_only && !in_interrupt() && !oops_in_progress;
+}
+
+/*
+ * Program and erase keep the controller busy for hundreds of microseconds,
+ * sleep until the transfer end interrupt rather than polling for TREND.
+ */
+static void wait_completion_irq(struct sh_flctl *flctl)
+{
+	if (flctl->irq < 0 || !flctl_may_sleep(flctl)) {
+		wait_completion(flctl);
+		return;
+	}
+
+	INIT_COMPLETION(flctl->trend);
+	writel(readl(FLINTDMACR(flctl)) | TEINTE, FLINTDMACR(flctl));
+
+	if (!wait_for_completion_timeout(&flctl->trend, FLCTL_TIMEOUT)) {
+		writel(readl(FLINTDMACR(flctl)) & ~TEINTE, FLINTDMACR(flctl));
+		timeout_error(flctl, __func__);
+		writeb(0x0, FLTRCR(flctl));
+	}
+}
+
+static irqreturn_t flctl_handle_flte(int irq, void *dev_id)
+{
+	struct sh_flctl *flctl = dev_id;
+
+	if (!(readb(FLTRCR(flctl)) & TREND))
+		return IRQ_NONE;
+
+	writel(readl(FLINTDMACR(flctl)) & ~TEINTE, FLINTDMACR(flctl));
+	writeb(0x0, FLTRCR(flctl));
+	complete(&flctl->trend);
+
+	return IRQ_HANDLED;
+}
+
+#ifdef CONFIG_MTD_NAND_SH_FLCTL_DMA
+static void flctl_dma_complete(void *param)
+{
+	struct sh_flctl *flctl = param;
+
+	complete(&flctl->dma_done);
+}
+
+static bool flctl_dma_filter(struct dma_chan *chan, void *arg)
+{
+	dev_dbg(chan->device->dev, "%s: slave data %p\n", __func__, arg);
+	chan->private = arg;
+	return true;
+}
+
+static void flctl_request_dma(struct sh_flctl *flctl,
+			      struct sh_flctl_platform_data *pdata)
+{
+	dma_cap_mask_t mask;
+
+	/* We can only either use DMA for both Tx and Rx or not use it at all */
+	if (pdata->dma_slave_tx <= 0 || pdata->dma_slave_rx <= 0)
+		return;
+
+	init_completion(&flctl->dma_done);
+
+	dma_cap_zero(mask);
+	dma_cap_set(DMA_SLAVE, mask);
+
+	flctl->param_tx.slave_id = pdata->dma_slave_tx;
+	flctl->chan_fifo0_tx = dma_request_channel(mask, flctl_dma_filter,
+						   &flctl->param_tx);
+	if (!flctl->chan_fifo0_tx)
+		return;
+
+	flctl->param_rx.slave_id = pdata->dma_slave_rx;
+	flctl->chan_fifo0_rx = dma_request_channel(mask, flctl_dma_filter,
+						   &flctl->param_rx);
+	if (!flctl->chan_fifo0_rx) {
+		dma_release_channel(flctl->chan_fifo0_tx);
+		flctl->chan_fifo0_tx = NULL;
+		return;
+	}
+
+	dev_info(&flctl->pdev->dev, "using DMA channels %s (Tx), %s (Rx)\n",
+		 dma_chan_name(flctl->chan_fifo0_tx),
+		 dma_chan_name(flctl->chan_fifo0_rx));
+}
+
+static void flctl_release_dma(struct sh_flctl *flctl)
+{
+	if (flctl->chan_fifo0_rx) {
+		dma_release_channel(flctl->chan_fifo0_rx);
+		flctl->chan_fifo0_rx = NULL;
+	}
+	if (flctl->chan_fifo0_tx) {
+		dma_release_channel(flctl->chan_fifo0_tx);
+		flctl->chan_fifo0_tx = NULL;
+	}
+}
+
+/*
+ * Move @len bytes of done_buff from/to the data FIFO with the DMAC.
+ * Returns -EAGAIN if nothing was started, so that the caller can still
+ * fall back to PIO.
+ */
+static int flctl_dma_fifo0_transfer(struct sh_flctl *flctl, int offset,
+				    int len, enum dma_data_direction dir)
+{
+	unsigned long *buf = (unsigned long *)&flctl->done_buff[offset];
+	struct dma_async_tx_descriptor *desc;
+	struct dma_chan *chan;
+	struct scatterlist sg;
+	dma_cookie_t cookie;
+	int i, ret = -EAGAIN;
+
+	if (dir == DMA_FROM_DEVICE)
+		chan = flctl->chan_fifo0_rx;
+	else
+		chan = flctl->chan_fifo0_tx;
+
+	/* Whole sectors and pages only, OOB is quicker to copy by hand */
+	if (!chan || len < 512 || (len & 3) || !flctl_may_sleep(flctl))
+		return -EAGAIN;
+
+	/* The FIFO is big endian, see read_fiforeg() and write_fiforeg() */
+	if (dir == DMA_TO_DEVICE)
+		for (i = 0; i < len / 4; i++)
+			buf[i] = cpu_to_be32(buf[i]);
+
+	sg_init_one(&sg, buf, len);
+	if (!dma_map_sg(chan->device->dev, &sg, 1, dir))
+		goto out;
+
+	desc = chan->device->device_prep_slave_sg(chan, &sg, 1, dir,
+					DMA_PREP_INTERRUPT | DMA_CTRL_ACK);
+	if (!desc)
+		goto out_unmap;
+
+	desc->callback = flctl_dma_complete;
+	desc->callback_param = flctl;
+	INIT_COMPLETION(flctl->dma_done);
+
+	cookie = desc->tx_submit(desc);
+	if (cookie < 0)
+		goto out_unmap;
+
+	/* Let the data FIFO raise DMA requests */
+	writel(readl(FLINTDMACR(flctl)) | DREQ0EN, FLINTDMACR(flctl));
+	dma_async_issue_pending(chan);
+
+	ret = 0;
+	if (!wait_for_completion_timeout(&flctl->dma_done, FLCTL_TIMEOUT)) {
+		chan->device->device_terminate_all(chan);
+		timeout_error(flctl, __func__);
+		ret = -ETIMEDOUT;
+	}
+
+	writel(readl(FLINTDMACR(flctl)) & ~DREQ0EN, FLINTDMACR(flctl));
+
+ out_unmap:
+	dma_unmap_sg(chan->device->dev, &sg, 1, dir);
+ out:
+	/* Leave done_buff in CPU byte order, whichever way this went */
+	if (dir == DMA_TO_DEVICE || ret != -EAGAIN)
+		for (i = 0; i < len / 4; i++)
+			buf[i] = be32_to_cpu(buf[i]);
+
+	return ret;
+}
+#else
+static inline void flctl_request_dma(struct sh_flctl *flctl,
+				     struct sh_flctl_platform_data *pdata)
+{
+}
+
+static inline void flctl_release_dma(struct sh_flctl *flctl)
+{
+}
+
+static inline int flctl_dma_fifo0_transfer(struct sh_flctl *flctl,
+					   int offset, int len,
+					   enum dma_data_direction dir)
+{
+	return -EAGAIN;
+}
+#endif
+
 static void set_addr(struct mtd_info *mtd, int column, int page_addr)
 {
 	struct sh_flctl *flctl = mtd_to_flctl(mtd);
@@ -235,12 +436,20 @@ static void read_datareg(struct sh_flctl *flctl, int offset)
 	*buf = le32_to_cpu(data);
 }
 
-static void read_fiforeg(struct sh_flctl *flctl, int rlen, int offset)
+/*
+ * A DMA transfer that timed out leaves the FIFO at an unknown position, so
+ * it can't be finished by PIO. The error is returned instead.
+ */
+static int read_fiforeg(struct sh_flctl *flctl, int rlen, int offset)
 {
-	int i, len_4align;
+	int i, len_4align, ret;
 	unsigned long *buf = (unsigned long *)&flctl->done_buff[offset];
 	void *fifo_addr = (void *)FLDTFIFO(flctl);
 
+	ret = flctl_dma_fifo0_transfer(flctl, offset, rlen, DMA_FROM_DEVICE);
+	if (ret != -EAGAIN)
+		return ret;
+
 	len_4align = (rlen + 3) / 4;
 
 	for (i = 0; i < len_4align; i++) {
@@ -248,6 +457,8 @@ static void read_fiforeg(struct sh_flctl *flctl, int rlen, int offset)
 		buf[i] = readl(fifo_addr);
 		buf[i] = be32_to_cpu(buf[i]);
 	}
+
+	return 0;
 }
 
 static int read_ecfiforeg(struct sh_flctl *flctl, uint8_t *buff, int sector)
@@ -268,10 +479,18 @@ static int read_ecfiforeg(struct sh_flctl *flctl, uint8_t *buff, int sector)
 
 static void write_fiforeg(struct sh_flctl *flctl, int rlen, int offset)
 {
-	int i, len_4align;
+	int i, len_4align, ret;
 	unsigned long *data = (unsigned long *)&flctl->done_buff[offset];
 	void *fifo_addr = (void *)FLDTFIFO(flctl);
 
+	ret = flctl_dma_fifo0_transfer(flctl, offset, rlen, DMA_TO_DEVICE);
+	if (ret != -EAGAIN) {
+		/* Fail the program operation at the next status read */
+		if (ret)
+			flctl->write_failed = 1;
+		return;
+	}
+
 	len_4align = (rlen + 3) / 4;
 	for (i = 0; i < len_4align; i++) {
 		wait_wfifo_ready(flctl);
@@ -351,11 +570,9 @@ static int flctl_read_page_hwecc(struct mtd_info *mtd, struct nand_chip *chip,
 	for (i = 0; eccsteps; eccsteps--, i += eccbytes, p += eccsize)
 		chip->read_buf(mtd, p, eccsize);
 
-	for (i = 0; eccsteps; eccsteps--, i += eccbytes, p += eccsize) {
+	for (i = 0; i < chip->ecc.steps; i++) {
 		if (flctl->hwecc_cant_correct[i])
 			mtd->ecc_stats.failed++;
-		else
-			mtd->ecc_stats.corrected += 0;
 	}
 
 	return 0;
@@ -392,14 +609,17 @@ static void execmd_read_page_sector(struct mtd_info *mtd, int page_addr)
 	for (sector = 0; sector < page_sectors; sector++) {
 		int ret;
 
+		flctl->hwecc_cant_correct[sector] = 0;
+
 		empty_fifo(flctl);
 		writel(readl(FLCMDCR(flctl)) | 1, FLCMDCR(flctl));
 		writel(page_addr << 2 | sector, FLADR(flctl));
 
 		start_translation(flctl);
-		read_fiforeg(flctl, 512, 512 * sector);
+		ret = read_fiforeg(flctl, 512, 512 * sector);
 
-		ret = read_ecfiforeg(flctl,
+		/* A failed transfer reads as an uncorrectable sector */
+		ret |= read_ecfiforeg(flctl,
 			&flctl->done_buff[mtd->writesize + 16 * sector],
 			sector);
 
@@ -472,7 +692,7 @@ static void execmd_write_page_sector(struct mtd_info *mtd)
 			wait_wecfifo_ready(flctl); /* wait for write ready */
 			writel(0xFFFFFFFF, FLECFIFO(flctl));
 		}
-		wait_completion(flctl);
+		wait_completion_irq(flctl);
 	}
 
 	writel(readl(FLCMNCR(flctl)) & ~ACM_SACCES_MODE, FLCMNCR(flctl));
@@ -502,7 +722,7 @@ static void execmd_write_oob(struct mtd_info *mtd)
 
 		start_translation(flctl);
 		write_fiforeg(flctl, 16, 16 * sector);
-		wait_completion(flctl);
+		wait_completion_irq(flctl);
 	}
 }
 
@@ -578,7 +798,7 @@ static void flctl_cmdfunc(struct mtd_info *mtd, unsigned int command,
 			(command << 8) | NAND_CMD_ERASE1);
 		set_addr(mtd, -1, flctl->erase1_page_addr);
 		start_translation(flctl);
-		wait_completion(flctl);
+		wait_completion_irq(flctl);
 		break;
 
 	case NAND_CMD_SEQIN:
@@ -624,7 +844,7 @@ static void flctl_cmdfunc(struct mtd_info *mtd, unsigned int command,
 		writel(flctl->index, FLDTCNTR(flctl));	/* set write size */
 		start_translation(flctl);
 		write_fiforeg(flctl, flctl->index, 0);
-		wait_completion(flctl);
+		wait_completion_irq(flctl);
 		break;
 
 	case NAND_CMD_STATUS:
@@ -635,6 +855,11 @@ static void flctl_cmdfunc(struct mtd_info *mtd, unsigned int command,
 		writel(flctl->read_bytes, FLDTCNTR(flctl)); /* set read size */
 		start_translation(flctl);
 		read_datareg(flctl, 0); /* read and end */
+
+		if (flctl->write_failed) {
+			flctl->done_buff[0] |= NAND_STATUS_FAIL;
+			flctl->write_failed = 0;
+		}
 		break;
 
 	case NAND_CMD_RESET:
@@ -794,6 +1019,110 @@ static int flctl_chip_init_tail(struct mtd_info *mtd)
 	return 0;
 }
 
+#ifdef CONFIG_DEBUG_FS
+/* As many eraseblocks as mtd_speedtest would take on a small device */
+#define FLCTL_SPEEDTEST_BLOCKS	16
+
+/*
+ * Read the first good eraseblocks the way mtd_speedtest does and return
+ * the throughput in KiB/s. This does not modify the flash contents.
+ */
+static long flctl_speedtest_read(struct sh_flctl *flctl, void *buf)
+{
+	struct mtd_info *mtd = &flctl->mtd;
+	ktime_t start = ktime_get();
+	int blocks = 0;
+	size_t read;
+	loff_t addr;
+	u64 ns;
+	int ret;
+
+	for (addr = 0; addr < mtd->size && blocks < FLCTL_SPEEDTEST_BLOCKS;
+	     addr += mtd->erasesize) {
+		if (mtd->block_isbad(mtd, addr))
+			continue;
+
+		ret = mtd->read(mtd, addr, mtd->erasesize, &read, buf);
+		/* Corrected bitflips do not matter here */
+		if (ret && ret != -EUCLEAN)
+			return ret;
+		blocks++;
+	}
+
+	ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+	if (!blocks || !ns)
+		return -EIO;
+
+	return div64_u64((u64)blocks * mtd->erasesize * (NSEC_PER_SEC / 1024),
+			 ns);
+}
+
+static int flctl_speedtest_show(struct seq_file *s, void *unused)
+{
+	struct sh_flctl *flctl = s->private;
+	long pio, fast;
+	void *buf;
+
+	buf = vmalloc(flctl->mtd.erasesize);
+	if (!buf)
+		return -ENOMEM;
+
+	flctl->pio_only = 1;
+	pio = flctl_speedtest_read(flctl, buf);
+	flctl->pio_only = 0;
+	fast = flctl_speedtest_read(flctl, buf);
+
+	vfree(buf);
+
+	if (pio < 0)
+		return pio;
+	if (fast < 0)
+		return fast;
+
+	seq_printf(s, "polled PIO: eraseblock read speed is %ld KiB/s\n", pio);
+	seq_printf(s, "%s: eraseblock read speed is %ld KiB/s\n",
+		   flctl->irq < 0 ? "DMA" : "DMA + irq", fast);
+
+	return 0;
+}
+
+static int flctl_speedtest_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, flctl_speedtest_show, inode->i_private);
+}
+
+static const struct file_operations flctl_speedtest_fops = {
+	.owner		= THIS_MODULE,
+	.open		= flctl_speedtest_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static void flctl_debugfs_init(struct sh_flctl *flctl)
+{
+	flctl->debugfs = debugfs_create_dir(dev_name(&flctl->pdev->dev), NULL);
+	if (!flctl->debugfs)
+		return;
+
+	debugfs_create_file("speedtest", S_IRUSR, flctl->debugfs, flctl,
+			    &flctl_speedtest_fops);
+}
+
+static void flctl_debugfs_remove(struct sh_flctl *flctl)
+{
+	debugfs_remove_recursive(flctl->debugfs);
+}
+#else
+static inline void flctl_debugfs_init(struct sh_flctl *flctl)
+{
+}
+
+static inline void flctl_debugfs_remove(struct sh_flctl *flctl)
+{
+}
+#endif /* CONFIG_DEBUG_FS */
+
 static int __devinit flctl_probe(struct platform_device *pdev)
 {
 	struct resource *res;
@@ -833,9 +1162,21 @@ static int __devinit flctl_probe(struct platform_device *pdev)
 	flctl_mtd->priv = nand;
 	flctl->pdev = pdev;
 	flctl->hwecc = pdata->has_hwecc;
+	init_completion(&flctl->trend);
 
 	flctl_register_init(flctl, pdata->flcmncr_val);
 
+	/* Without the transfer end interrupt we just keep polling */
+	flctl->irq = platform_get_irq(pdev, 0);
+	if (flctl->irq >= 0 &&
+	    request_irq(flctl->irq, flctl_handle_flte, IRQF_DISABLED,
+			dev_name(&pdev->dev), flctl)) {
+		dev_warn(&pdev->dev, "failed to request irq %d\n", flctl->irq);
+		flctl->irq = -ENXIO;
+	}
+
+	flctl_request_dma(flctl, pdata);
+
 	nand->options = NAND_NO_AUTOINCR;
 
 	/* Set address of hardware control function */
@@ -856,20 +1197,26 @@ static int __devinit flctl_probe(struct platform_device *pdev)
 
 	ret = nand_scan_ident(flctl_mtd, 1);
 	if (ret)
-		goto err;
+		goto err_chip;
 
 	ret = flctl_chip_init_tail(flctl_mtd);
 	if (ret)
-		goto err;
+		goto err_chip;
 
 	ret = nand_scan_tail(flctl_mtd);
 	if (ret)
-		goto err;
+		goto err_chip;
 
 	add_mtd_partitions(flctl_mtd, pdata->parts, pdata->nr_parts);
+	flctl_debugfs_init(flctl);
 
 	return 0;
 
+err_chip:
+	flctl_release_dma(flctl);
+	if (flctl->irq >= 0)
+		free_irq(flctl->irq, flctl);
+	iounmap(flctl->reg);
 err:
 	kfree(flctl);
 	return ret;
@@ -879,7 +1226,12 @@ static int __devexit flctl_remove(struct platform_device *pdev)
 {
 	struct sh_flctl *flctl = platform_get_drvdata(pdev);
 
+	flctl_debugfs_remove(flctl);
 	nand_release(&flctl->mtd);
+	flctl_release_dma(flctl);
+	if (flctl->irq >= 0)
+		free_irq(flctl->irq, flctl);
+	iounmap(flctl->reg);
 	kfree(flctl);
 
 	return 0;
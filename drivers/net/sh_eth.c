@@ -27,6 +27,8 @@
 #include <linux/platform_device.h>
 #include <linux/mdio-bitbang.h>
 #include <linux/netdevice.h>
+#include <linux/ethtool.h>
+#include <linux/hrtimer.h>
 #include <linux/phy.h>
 #include <linux/cache.h>
 #include <linux/io.h>
@@ -35,6 +37,15 @@
 
 #include "sh_eth.h"
 
+static int rx_budget = SH_ETH_NAPI_WEIGHT;
+module_param(rx_budget, int, 0444);
+MODULE_PARM_DESC(rx_budget, "Maximum number of frames received per NAPI poll");
+
+static int copybreak __read_mostly = SH_ETH_COPYBREAK_DEFAULT;
+module_param(copybreak, int, 0644);
+MODULE_PARM_DESC(copybreak,
+	"Maximum size of frame that is copied to a new skb on receive");
+
 /* There is CPU dependent code */
 #if defined(CONFIG_CPU_SUBTYPE_SH7724)
 #define SH_ETH_RESET_DEFAULT	1
@@ -392,6 +403,41 @@ static struct mdiobb_ops bb_ops = {
 	.get_mdio_data = sh_get_mdio,
 };
 
+/* Get a mapped and aligned Rx buffer */
+static struct sk_buff *sh_eth_rx_skb_get(struct net_device *ndev)
+{
+	struct sh_eth_private *mdp = netdev_priv(ndev);
+	struct sk_buff *skb;
+
+	skb = dev_alloc_skb(mdp->rx_buf_sz);
+	if (skb == NULL) {
+		mdp->rx_alloc_failed++;
+		return NULL;
+	}
+	mdp->rx_alloc++;
+
+	dma_map_single(&ndev->dev, skb->tail, mdp->rx_buf_sz,
+			DMA_FROM_DEVICE);
+	skb->dev = ndev; /* Mark as being used by this device. */
+	sh_eth_set_receive_align(skb);
+	skb->ip_summed = CHECKSUM_NONE;
+
+	return skb;
+}
+
+/* Unmap the fragment page behind a Tx descriptor, if any */
+static void sh_eth_tx_unmap(struct net_device *ndev, int entry)
+{
+	struct sh_eth_private *mdp = netdev_priv(ndev);
+	struct sh_eth_txfrag *frag = &mdp->tx_frag[entry];
+
+	if (frag->len) {
+		dma_unmap_page(&ndev->dev, frag->dma, frag->len,
+			       DMA_TO_DEVICE);
+		frag->len = 0;
+	}
+}
+
 /* free skb and descriptor buffer */
 static void sh_eth_ring_free(struct net_device *ndev)
 {
@@ -408,6 +454,13 @@ static void sh_eth_ring_free(struct net_device *ndev)
 	kfree(mdp->rx_skbuff);
 
 	/* Free Tx skb ringbuffer */
+	if (mdp->tx_frag) {
+		for (i = 0; i < TX_RING_SIZE; i++)
+			sh_eth_tx_unmap(ndev, i);
+	}
+	kfree(mdp->tx_frag);
+	mdp->tx_frag = NULL;
+
 	if (mdp->tx_skbuff) {
 		for (i = 0; i < TX_RING_SIZE; i++) {
 			if (mdp->tx_skbuff[i])
@@ -438,14 +491,10 @@ static void sh_eth_ring_format(struct net_device *ndev)
 	for (i = 0; i < RX_RING_SIZE; i++) {
 		/* skb */
 		mdp->rx_skbuff[i] = NULL;
-		skb = dev_alloc_skb(mdp->rx_buf_sz);
+		skb = sh_eth_rx_skb_get(ndev);
 		mdp->rx_skbuff[i] = skb;
 		if (skb == NULL)
 			break;
-		dma_map_single(&ndev->dev, skb->tail, mdp->rx_buf_sz,
-				DMA_FROM_DEVICE);
-		skb->dev = ndev; /* Mark as being used by this device. */
-		sh_eth_set_receive_align(skb);
 
 		/* RX descriptor */
 		rxdesc = &mdp->rx_ring[i];
@@ -522,6 +571,14 @@ static int sh_eth_ring_init(struct net_device *ndev)
 		goto skb_ring_free;
 	}
 
+	mdp->tx_frag = kzalloc(sizeof(*mdp->tx_frag) * TX_RING_SIZE,
+			       GFP_KERNEL);
+	if (!mdp->tx_frag) {
+		dev_err(&ndev->dev, "Cannot allocate Tx fragment map\n");
+		ret = -ENOMEM;
+		goto skb_ring_free;
+	}
+
 	/* Allocate all Rx descriptors. */
 	rx_ringsize = sizeof(struct sh_eth_rxdesc) * RX_RING_SIZE;
 	mdp->rx_ring = dma_alloc_coherent(NULL, rx_ringsize, &mdp->rx_desc_dma,
@@ -657,34 +714,68 @@ static int sh_eth_txfree(struct net_device *ndev)
 		txdesc = &mdp->tx_ring[entry];
 		if (txdesc->status & cpu_to_edmac(mdp, TD_TACT))
 			break;
-		/* Free the original skb. */
+		sh_eth_tx_unmap(ndev, entry);
+		/* Free the original skb, it sits on the last descriptor. */
 		if (mdp->tx_skbuff[entry]) {
 			dev_kfree_skb_irq(mdp->tx_skbuff[entry]);
 			mdp->tx_skbuff[entry] = NULL;
 			freeNum++;
+			mdp->stats.tx_packets++;
 		}
 		txdesc->status = cpu_to_edmac(mdp, TD_TFP);
 		if (entry >= TX_RING_SIZE - 1)
 			txdesc->status |= cpu_to_edmac(mdp, TD_TDLE);
 
-		mdp->stats.tx_packets++;
 		mdp->stats.tx_bytes += txdesc->buffer_length;
 	}
 	return freeNum;
 }
 
-/* Packet receive function */
-static int sh_eth_rx(struct net_device *ndev)
+/*
+ * Copy a small frame into a new skb. The ring buffer stays in place and
+ * only the part of it the CPU touched has to be invalidated again.
+ */
+static struct sk_buff *sh_eth_rx_copybreak(struct net_device *ndev,
+					   struct sh_eth_rxdesc *rxdesc,
+					   u16 pkt_len)
+{
+	struct sh_eth_private *mdp = netdev_priv(ndev);
+	int pad = mdp->cd->rpadir ? NET_IP_ALIGN : 0;
+	struct sk_buff *skb;
+
+	skb = netdev_alloc_skb(ndev, pkt_len + NET_IP_ALIGN);
+	if (skb == NULL)
+		return NULL;
+
+	skb_reserve(skb, NET_IP_ALIGN);
+	memcpy(skb_put(skb, pkt_len), phys_to_virt(rxdesc->addr) + pad,
+	       pkt_len);
+
+	/* Covers the RPADIR padding and the soft swap overrun */
+	dma_sync_single_for_device(&ndev->dev, rxdesc->addr,
+				   ALIGN(pad + pkt_len + 2, 4),
+				   DMA_FROM_DEVICE);
+	mdp->rx_copybreak++;
+
+	return skb;
+}
+
+/* Packet receive function, returns the number of descriptors processed */
+static int sh_eth_rx(struct net_device *ndev, int quota)
 {
 	struct sh_eth_private *mdp = netdev_priv(ndev);
 	struct sh_eth_rxdesc *rxdesc;
 
 	int entry = mdp->cur_rx % RX_RING_SIZE;
 	int boguscnt = (mdp->dirty_rx + RX_RING_SIZE) - mdp->cur_rx;
+	int work_done = 0;
 	struct sk_buff *skb;
 	u16 pkt_len = 0;
 	u32 desc_status;
 
+	if (boguscnt > quota)
+		boguscnt = quota;
+
 	rxdesc = &mdp->rx_ring[entry];
 	while (!(rxdesc->status & cpu_to_edmac(mdp, RD_RACT))) {
 		desc_status = edmac_to_cpu(mdp, rxdesc->status);
@@ -693,6 +784,8 @@ static int sh_eth_rx(struct net_device *ndev)
 		if (--boguscnt < 0)
 			break;
 
+		work_done++;
+
 		if (!(desc_status & RDFEND))
 			mdp->stats.rx_length_errors++;
 
@@ -716,13 +809,19 @@ static int sh_eth_rx(struct net_device *ndev)
 				sh_eth_soft_swap(
 					phys_to_virt(ALIGN(rxdesc->addr, 4)),
 					pkt_len + 2);
-			skb = mdp->rx_skbuff[entry];
-			mdp->rx_skbuff[entry] = NULL;
-			if (mdp->cd->rpadir)
-				skb_reserve(skb, NET_IP_ALIGN);
-			skb_put(skb, pkt_len);
+			skb = NULL;
+			if (pkt_len < copybreak)
+				skb = sh_eth_rx_copybreak(ndev, rxdesc,
+							  pkt_len);
+			if (skb == NULL) {
+				skb = mdp->rx_skbuff[entry];
+				mdp->rx_skbuff[entry] = NULL;
+				if (mdp->cd->rpadir)
+					skb_reserve(skb, NET_IP_ALIGN);
+				skb_put(skb, pkt_len);
+			}
 			skb->protocol = eth_type_trans(skb, ndev);
-			netif_rx(skb);
+			netif_receive_skb(skb);
 			mdp->stats.rx_packets++;
 			mdp->stats.rx_bytes += pkt_len;
 		}
@@ -739,16 +838,10 @@ static int sh_eth_rx(struct net_device *ndev)
 		rxdesc->buffer_length = ALIGN(mdp->rx_buf_sz, 16);
 
 		if (mdp->rx_skbuff[entry] == NULL) {
-			skb = dev_alloc_skb(mdp->rx_buf_sz);
+			skb = sh_eth_rx_skb_get(ndev);
 			mdp->rx_skbuff[entry] = skb;
 			if (skb == NULL)
 				break;	/* Better luck next round. */
-			dma_map_single(&ndev->dev, skb->tail, mdp->rx_buf_sz,
-					DMA_FROM_DEVICE);
-			skb->dev = ndev;
-			sh_eth_set_receive_align(skb);
-
-			skb->ip_summed = CHECKSUM_NONE;
 			rxdesc->addr = virt_to_phys(PTR_ALIGN(skb->data, 4));
 		}
 		if (entry >= RX_RING_SIZE - 1)
@@ -764,7 +857,72 @@ static int sh_eth_rx(struct net_device *ndev)
 	if (!(ctrl_inl(ndev->base_addr + EDRRR) & EDRRR_R))
 		ctrl_outl(EDRRR_R, ndev->base_addr + EDRRR);
 
-	return 0;
+	return work_done;
+}
+
+/* Unmask the Rx interrupt sources masked by sh_eth_interrupt() */
+static void sh_eth_rx_irq_enable(struct net_device *ndev)
+{
+	struct sh_eth_private *mdp = netdev_priv(ndev);
+	u32 ioaddr = ndev->base_addr;
+	unsigned long flags;
+
+	spin_lock_irqsave(&mdp->lock, flags);
+	if (netif_running(ndev))
+		ctrl_outl(ctrl_inl(ioaddr + EESIPR) |
+			  (mdp->cd->eesipr_value & EESR_RX_CHECK),
+			  ioaddr + EESIPR);
+	spin_unlock_irqrestore(&mdp->lock, flags);
+}
+
+static enum hrtimer_restart sh_eth_rx_coalesce_timer(struct hrtimer *timer)
+{
+	struct sh_eth_private *mdp = container_of(timer, struct sh_eth_private,
+						  rx_coalesce_timer);
+
+	sh_eth_rx_irq_enable(mdp->napi.dev);
+
+	return HRTIMER_NORESTART;
+}
+
+/* NAPI poll function */
+static int sh_eth_poll(struct napi_struct *napi, int budget)
+{
+	struct sh_eth_private *mdp = container_of(napi, struct sh_eth_private,
+						  napi);
+	struct net_device *ndev = napi->dev;
+	u32 ioaddr = ndev->base_addr;
+	int work_done = 0;
+	u32 intr_status;
+
+	for (;;) {
+		/* Clear Rx interrupts before looking at the descriptors */
+		intr_status = ctrl_inl(ioaddr + EESR);
+		ctrl_outl(intr_status & EESR_RX_CHECK, ioaddr + EESR);
+
+		work_done += sh_eth_rx(ndev, budget - work_done);
+		if (work_done >= budget)
+			return budget;
+
+		/* Go round again if more frames arrived meanwhile */
+		if (!(ctrl_inl(ioaddr + EESR) & EESR_RX_CHECK))
+			break;
+	}
+
+	napi_complete(napi);
+
+	/*
+	 * Hold off the next Rx interrupt for rx_coalesce_usecs, frames
+	 * arriving in the meantime are left pending in EESR.
+	 */
+	if (mdp->rx_coalesce_usecs)
+		hrtimer_start(&mdp->rx_coalesce_timer,
+			      ns_to_ktime(mdp->rx_coalesce_usecs * NSEC_PER_USEC),
+			      HRTIMER_MODE_REL);
+	else
+		sh_eth_rx_irq_enable(ndev);
+
+	return work_done;
 }
 
 /* error control function */
@@ -878,30 +1036,27 @@ static irqreturn_t sh_eth_interrupt(int irq, void *netdev)
 	struct sh_eth_private *mdp = netdev_priv(ndev);
 	struct sh_eth_cpu_data *cd = mdp->cd;
 	irqreturn_t ret = IRQ_NONE;
-	u32 ioaddr, intr_status = 0;
+	u32 ioaddr, intr_status = 0, intr_enable;
 
 	ioaddr = ndev->base_addr;
 	spin_lock(&mdp->lock);
 
-	/* Get interrpt stat */
+	/* Get interrpt stat, ignoring the sources masked during polling */
 	intr_status = ctrl_inl(ioaddr + EESR);
-	/* Clear interrupt */
-	if (intr_status & (EESR_FRC | EESR_RMAF | EESR_RRF |
-			EESR_RTLF | EESR_RTSF | EESR_PRE | EESR_CERF |
-			cd->tx_check | cd->eesr_err_check)) {
-		ctrl_outl(intr_status, ioaddr + EESR);
+	intr_enable = ctrl_inl(ioaddr + EESIPR);
+	intr_status &= intr_enable | DMAC_M_ECI;
+	/* Clear interrupt, Rx events are cleared by sh_eth_poll() */
+	if (intr_status & (EESR_RX_CHECK | cd->tx_check |
+			   cd->eesr_err_check)) {
+		ctrl_outl(intr_status & ~EESR_RX_CHECK, ioaddr + EESR);
 		ret = IRQ_HANDLED;
 	} else
 		goto other_irq;
 
-	if (intr_status & (EESR_FRC | /* Frame recv*/
-			EESR_RMAF | /* Multi cast address recv*/
-			EESR_RRF  | /* Bit frame recv */
-			EESR_RTLF | /* Long frame recv*/
-			EESR_RTSF | /* short frame recv */
-			EESR_PRE  | /* PHY-LSI recv error */
-			EESR_CERF)){ /* recv frame CRC error */
-		sh_eth_rx(ndev);
+	if (intr_status & EESR_RX_CHECK) {
+		/* Mask Rx interrupts until the poll is complete */
+		ctrl_outl(intr_enable & ~EESR_RX_CHECK, ioaddr + EESIPR);
+		napi_schedule(&mdp->napi);
 	}
 
 	/* Tx Check */
@@ -1021,6 +1176,8 @@ static int sh_eth_open(struct net_device *ndev)
 
 	pm_runtime_get_sync(&mdp->pdev->dev);
 
+	napi_enable(&mdp->napi);
+
 	ret = request_irq(ndev->irq, sh_eth_interrupt,
 #if defined(CONFIG_CPU_SUBTYPE_SH7763) || defined(CONFIG_CPU_SUBTYPE_SH7764)
 				IRQF_SHARED,
@@ -1030,7 +1187,7 @@ static int sh_eth_open(struct net_device *ndev)
 				ndev->name, ndev);
 	if (ret) {
 		dev_err(&ndev->dev, "Can not assign IRQ number\n");
-		return ret;
+		goto out_napi_off;
 	}
 
 	/* Descriptor set */
@@ -1057,6 +1214,8 @@ static int sh_eth_open(struct net_device *ndev)
 
 out_free_irq:
 	free_irq(ndev->irq, ndev);
+out_napi_off:
+	napi_disable(&mdp->napi);
 	pm_runtime_put_sync(&mdp->pdev->dev);
 	return ret;
 }
@@ -1091,6 +1250,7 @@ static void sh_eth_tx_timeout(struct net_device *ndev)
 		mdp->rx_skbuff[i] = NULL;
 	}
 	for (i = 0; i < TX_RING_SIZE; i++) {
+		sh_eth_tx_unmap(ndev, i);
 		if (mdp->tx_skbuff[i])
 			dev_kfree_skb(mdp->tx_skbuff[i]);
 		mdp->tx_skbuff[i] = NULL;
@@ -1104,17 +1264,47 @@ static void sh_eth_tx_timeout(struct net_device *ndev)
 	add_timer(&mdp->timer);
 }
 
+/* Hand a Tx descriptor over to the E-DMAC */
+static void sh_eth_tx_desc_activate(struct sh_eth_private *mdp,
+				    struct sh_eth_txdesc *txdesc, u32 entry,
+				    u32 status)
+{
+	status |= TD_TACT;
+	if (entry >= TX_RING_SIZE - 1)
+		status |= TD_TDLE;
+	txdesc->status = cpu_to_edmac(mdp, status);
+}
+
 /* Packet transmit function */
 static int sh_eth_start_xmit(struct sk_buff *skb, struct net_device *ndev)
 {
 	struct sh_eth_private *mdp = netdev_priv(ndev);
 	struct sh_eth_txdesc *txdesc;
-	u32 entry;
+	skb_frag_t *frag;
+	u32 entry, first;
 	unsigned long flags;
+	int nr_frags, i;
+
+	/*
+	 * There is no checksum engine, see sh_eth_drv_probe(). Summing the
+	 * fragments here still saves the copy the stack would otherwise do
+	 * to checksum a page cache send into a linear buffer.
+	 */
+	if (skb->ip_summed == CHECKSUM_PARTIAL && skb_checksum_help(skb))
+		goto drop;
+
+	/* Short frames are padded by the E-DMAC reading past the data */
+	if (skb_is_nonlinear(skb) && skb->len < ETHERSMALL &&
+	    skb_linearize(skb))
+		goto drop;
+
+	nr_frags = skb_shinfo(skb)->nr_frags;
 
 	spin_lock_irqsave(&mdp->lock, flags);
-	if ((mdp->cur_tx - mdp->dirty_tx) >= (TX_RING_SIZE - 4)) {
-		if (!sh_eth_txfree(ndev)) {
+	if ((mdp->cur_tx - mdp->dirty_tx) + nr_frags >= (TX_RING_SIZE - 4)) {
+		sh_eth_txfree(ndev);
+		if ((mdp->cur_tx - mdp->dirty_tx) + nr_frags >=
+		    (TX_RING_SIZE - 4)) {
 			netif_stop_queue(ndev);
 			spin_unlock_irqrestore(&mdp->lock, flags);
 			return NETDEV_TX_BUSY;
@@ -1122,8 +1312,7 @@ static int sh_eth_start_xmit(struct sk_buff *skb, struct net_device *ndev)
 	}
 	spin_unlock_irqrestore(&mdp->lock, flags);
 
-	entry = mdp->cur_tx % TX_RING_SIZE;
-	mdp->tx_skbuff[entry] = skb;
+	first = entry = mdp->cur_tx % TX_RING_SIZE;
 	txdesc = &mdp->tx_ring[entry];
 	txdesc->addr = virt_to_phys(skb->data);
 	/* soft swap. */
@@ -1131,24 +1320,49 @@ static int sh_eth_start_xmit(struct sk_buff *skb, struct net_device *ndev)
 		sh_eth_soft_swap(phys_to_virt(ALIGN(txdesc->addr, 4)),
 				 skb->len + 2);
 	/* write back */
-	__flush_purge_region(skb->data, skb->len);
-	if (skb->len < ETHERSMALL)
+	__flush_purge_region(skb->data, skb_headlen(skb));
+	if (nr_frags)
+		txdesc->buffer_length = skb_headlen(skb);
+	else if (skb->len < ETHERSMALL)
 		txdesc->buffer_length = ETHERSMALL;
 	else
 		txdesc->buffer_length = skb->len;
 
-	if (entry >= TX_RING_SIZE - 1)
-		txdesc->status |= cpu_to_edmac(mdp, TD_TACT | TD_TDLE);
-	else
-		txdesc->status |= cpu_to_edmac(mdp, TD_TACT);
+	/* One descriptor per fragment, the first one is activated last */
+	for (i = 0; i < nr_frags; i++) {
+		frag = &skb_shinfo(skb)->frags[i];
+		entry = (mdp->cur_tx + i + 1) % TX_RING_SIZE;
+		txdesc = &mdp->tx_ring[entry];
+		mdp->tx_frag[entry].dma = dma_map_page(&ndev->dev, frag->page,
+						       frag->page_offset,
+						       frag->size,
+						       DMA_TO_DEVICE);
+		mdp->tx_frag[entry].len = frag->size;
+		txdesc->addr = mdp->tx_frag[entry].dma;
+		txdesc->buffer_length = frag->size;
+		sh_eth_tx_desc_activate(mdp, txdesc, entry,
+					i == nr_frags - 1 ? TDFEND : 0);
+	}
+	mdp->tx_skbuff[entry] = skb;
 
-	mdp->cur_tx++;
+	wmb();
+	sh_eth_tx_desc_activate(mdp, &mdp->tx_ring[first], first,
+				nr_frags ? TDF1ST : TD_TFP);
 
+	mdp->cur_tx += nr_frags + 1;
+
+	/* Single doorbell for the whole frame, if the E-DMAC is idle */
 	if (!(ctrl_inl(ndev->base_addr + EDTRR) & EDTRR_TRNS))
 		ctrl_outl(EDTRR_TRNS, ndev->base_addr + EDTRR);
 
 	ndev->trans_start = jiffies;
 
+	return NETDEV_TX_OK;
+
+drop:
+	mdp->stats.tx_dropped++;
+	dev_kfree_skb_any(skb);
+
 	return NETDEV_TX_OK;
 }
 
@@ -1164,6 +1378,9 @@ static int sh_eth_close(struct net_device *ndev)
 	/* Disable interrupts by clearing the interrupt mask. */
 	ctrl_outl(0x0000, ioaddr + EESIPR);
 
+	napi_disable(&mdp->napi);
+	hrtimer_cancel(&mdp->rx_coalesce_timer);
+
 	/* Stop the chip's Tx and Rx processes. */
 	ctrl_outl(0, ioaddr + EDTRR);
 	ctrl_outl(0, ioaddr + EDRRR);
@@ -1367,6 +1584,81 @@ out:
 	return ret;
 }
 
+static int sh_eth_get_coalesce(struct net_device *ndev,
+			       struct ethtool_coalesce *ec)
+{
+	struct sh_eth_private *mdp = netdev_priv(ndev);
+
+	ec->rx_coalesce_usecs = mdp->rx_coalesce_usecs;
+	ec->rx_max_coalesced_frames = mdp->napi.weight;
+
+	return 0;
+}
+
+static int sh_eth_set_coalesce(struct net_device *ndev,
+			       struct ethtool_coalesce *ec)
+{
+	struct sh_eth_private *mdp = netdev_priv(ndev);
+
+	if (ec->rx_coalesce_usecs > SH_ETH_MAX_COALESCE_USECS)
+		return -EINVAL;
+	if (ec->rx_max_coalesced_frames < 1 ||
+	    ec->rx_max_coalesced_frames > RX_RING_SIZE)
+		return -EINVAL;
+
+	mdp->rx_coalesce_usecs = ec->rx_coalesce_usecs;
+	/* Picked up by net_rx_action() on the next poll */
+	mdp->napi.weight = ec->rx_max_coalesced_frames;
+
+	return 0;
+}
+
+static const char sh_eth_gstrings_stats[][ETH_GSTRING_LEN] = {
+	"rx_copybreak", "rx_alloc", "rx_alloc_failed",
+};
+#define SH_ETH_STATS_LEN  ARRAY_SIZE(sh_eth_gstrings_stats)
+
+static int sh_eth_get_sset_count(struct net_device *ndev, int stringset)
+{
+	switch (stringset) {
+	case ETH_SS_STATS:
+		return SH_ETH_STATS_LEN;
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
+static void sh_eth_get_strings(struct net_device *ndev, u32 stringset,
+			       u8 *data)
+{
+	switch (stringset) {
+	case ETH_SS_STATS:
+		memcpy(data, *sh_eth_gstrings_stats,
+		       sizeof(sh_eth_gstrings_stats));
+		break;
+	}
+}
+
+static void sh_eth_get_ethtool_stats(struct net_device *ndev,
+				     struct ethtool_stats *stats, u64 *data)
+{
+	struct sh_eth_private *mdp = netdev_priv(ndev);
+	int i = 0;
+
+	data[i++] = mdp->rx_copybreak;
+	data[i++] = mdp->rx_alloc;
+	data[i++] = mdp->rx_alloc_failed;
+}
+
+static const struct ethtool_ops sh_eth_ethtool_ops = {
+	.get_link		= ethtool_op_get_link,
+	.get_coalesce		= sh_eth_get_coalesce,
+	.set_coalesce		= sh_eth_set_coalesce,
+	.get_sset_count		= sh_eth_get_sset_count,
+	.get_strings		= sh_eth_get_strings,
+	.get_ethtool_stats	= sh_eth_get_ethtool_stats,
+};
+
 static const struct net_device_ops sh_eth_netdev_ops = {
 	.ndo_open		= sh_eth_open,
 	.ndo_stop		= sh_eth_close,
@@ -1442,10 +1734,27 @@ static int sh_eth_drv_probe(struct platform_device *pdev)
 	mdp->cd = &sh_eth_my_cpu_data;
 	sh_eth_set_default_cpu_data(mdp->cd);
 
+	/*
+	 * Fragments can't be soft swapped in place, so scatter-gather is
+	 * only offered when the E-DMAC does the byte swapping itself. The
+	 * core insists on a checksum feature alongside NETIF_F_SG, and
+	 * there is no checksum engine: start_xmit sums the frame in software.
+	 */
+	if (mdp->cd->hw_swap)
+		ndev->features |= NETIF_F_SG | NETIF_F_IP_CSUM;
+
 	/* set function */
 	ndev->netdev_ops = &sh_eth_netdev_ops;
+	SET_ETHTOOL_OPS(ndev, &sh_eth_ethtool_ops);
 	ndev->watchdog_timeo = TX_TIMEOUT;
 
+	/* NAPI and Rx interrupt mitigation */
+	netif_napi_add(ndev, &mdp->napi, sh_eth_poll,
+		       clamp_val(rx_budget, 1, RX_RING_SIZE));
+	hrtimer_init(&mdp->rx_coalesce_timer, CLOCK_MONOTONIC,
+		     HRTIMER_MODE_REL);
+	mdp->rx_coalesce_timer.function = sh_eth_rx_coalesce_timer;
+
 	mdp->post_rx = POST_RX >> (devno << 1);
 	mdp->post_fw = POST_FW >> (devno << 1);
 
@@ -1500,9 +1809,11 @@ out:
 static int sh_eth_drv_remove(struct platform_device *pdev)
 {
 	struct net_device *ndev = platform_get_drvdata(pdev);
+	struct sh_eth_private *mdp = netdev_priv(ndev);
 
 	sh_mdio_release(ndev);
 	unregister_netdev(ndev);
+	netif_napi_del(&mdp->napi);
 	flush_scheduled_work();
 	pm_runtime_disable(&pdev->dev);
 	free_netdev(ndev);
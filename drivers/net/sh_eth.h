@@ -29,6 +29,7 @@
 #include <linux/workqueue.h>
 #include <linux/netdevice.h>
 #include <linux/phy.h>
+#include <linux/hrtimer.h>
 
 #include <asm/sh_eth.h>
 
@@ -38,6 +39,9 @@
 #define RX_RING_SIZE	64	/* Rx ring size */
 #define ETHERSMALL		60
 #define PKT_BUF_SZ		1538
+#define SH_ETH_NAPI_WEIGHT	64	/* Default Rx budget per poll */
+#define SH_ETH_MAX_COALESCE_USECS	10000
+#define SH_ETH_COPYBREAK_DEFAULT	256
 
 #if defined(CONFIG_CPU_SUBTYPE_SH7763)
 /* This CPU register maps is very difference by other SH4 CPU */
@@ -412,6 +416,14 @@ enum EESR_BIT {
 	EESR_CERF	= 0x00000001,
 };
 
+#define EESR_RX_CHECK		(EESR_FRC | /* Frame recv*/		\
+				 EESR_RMAF | /* Multi cast address recv*/ \
+				 EESR_RRF  | /* Bit frame recv */	\
+				 EESR_RTLF | /* Long frame recv*/	\
+				 EESR_RTSF | /* short frame recv */	\
+				 EESR_PRE  | /* PHY-LSI recv error */	\
+				 EESR_CERF)  /* recv frame CRC error */
+
 #define DEFAULT_TX_CHECK	(EESR_FTC | EESR_CND | EESR_DLC | EESR_CD | \
 				 EESR_RTO)
 #define DEFAULT_EESR_ERR_CHECK	(EESR_TWB | EESR_TABT | EESR_RABT | \
@@ -650,6 +662,12 @@ struct sh_eth_txdesc {
 	u32 pad1;		/* padding data */
 } __attribute__((aligned(2), packed));
 
+/* Fragment page mapped behind a Tx descriptor, len is 0 if there is none */
+struct sh_eth_txfrag {
+	dma_addr_t dma;
+	u32 len;
+};
+
 /*
  * The sh ether Rx buffer descriptors.
  * This structure should be 20 bytes.
@@ -711,9 +729,17 @@ struct sh_eth_private {
 	struct sh_eth_txdesc *tx_ring;
 	struct sk_buff **rx_skbuff;
 	struct sk_buff **tx_skbuff;
+	struct sh_eth_txfrag *tx_frag;
 	struct net_device_stats stats;
 	struct timer_list timer;
 	spinlock_t lock;
+	struct napi_struct napi;
+	struct hrtimer rx_coalesce_timer;	/* Rx interrupt holdoff */
+	u32 rx_coalesce_usecs;
+	/* Rx buffer counters, see ethtool -S */
+	unsigned long rx_copybreak;	/* Copied, ring buffer reused */
+	unsigned long rx_alloc;		/* Refilled with a new skb */
+	unsigned long rx_alloc_failed;
 	u32 cur_rx, dirty_rx;	/* Producer/consumer ring indices */
 	u32 cur_tx, dirty_tx;
 	u32 rx_buf_sz;		/* Based on MTU+slack. */
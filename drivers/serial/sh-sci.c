@@ -48,6 +48,10 @@
 #include <linux/ctype.h>
 #include <linux/err.h>
 #include <linux/list.h>
+#include <linux/dmaengine.h>
+#include <linux/dma-mapping.h>
+#include <linux/scatterlist.h>
+#include <linux/workqueue.h>
 
 #ifdef CONFIG_SUPERH
 #include <asm/sh_bios.h>
@@ -57,6 +61,10 @@
 #include <asm/gpio.h>
 #endif
 
+#ifdef CONFIG_SERIAL_SH_SCI_DMA
+#include <asm/dma-sh.h>
+#endif
+
 #include "sh-sci.h"
 
 struct sci_port {
@@ -84,6 +92,35 @@ struct sci_port {
 	struct clk		*dclk;
 
 	struct list_head	node;
+
+#ifdef CONFIG_SERIAL_SH_SCI_DMA
+	/* DMA slaves from platform data, 0 if the port is PIO only */
+	int			slave_tx;
+	int			slave_rx;
+	struct sh_dmae_slave	param_tx;
+	struct sh_dmae_slave	param_rx;
+	struct dma_chan		*chan_tx;
+	struct dma_chan		*chan_rx;
+
+	/* Tx runs straight out of the circular xmit buffer */
+	dma_cookie_t		cookie_tx;
+	dma_addr_t		buf_tx_dma;
+	struct scatterlist	sg_tx;
+	unsigned int		sg_len_tx;
+	struct work_struct	work_tx;
+
+	/* Rx ping-pongs between two coherent buffers */
+	struct dma_async_tx_descriptor	*desc_rx[2];
+	dma_cookie_t		cookie_rx[2];
+	int			active_rx;	/* Buffer the DMAC is filling */
+	int			next_rx;	/* Buffer to submit next */
+	bool			rx_flush;
+	void			*buf_rx;
+	dma_addr_t		buf_rx_dma;
+	struct scatterlist	sg_rx[2];
+	struct work_struct	work_rx;
+	struct timer_list	rx_timer;
+#endif
 };
 
 struct sh_sci_priv {
@@ -618,8 +655,25 @@ static inline int sci_handle_breaks(struct uart_port *port)
 	return copied;
 }
 
-static irqreturn_t sci_rx_interrupt(int irq, void *port)
+static irqreturn_t sci_rx_interrupt(int irq, void *ptr)
 {
+	struct uart_port *port = ptr;
+
+#ifdef CONFIG_SERIAL_SH_SCI_DMA
+	struct sci_port *s = to_sci_port(port);
+
+	if (s->chan_rx) {
+		/*
+		 * The DMAC drains the FIFO, the interrupt only tells us that
+		 * reception has started. Mask it until the Rx timer has
+		 * pushed out whatever arrived in the meantime.
+		 */
+		sci_out(port, SCSCR, sci_in(port, SCSCR) & ~SCI_CTRL_FLAGS_RIE);
+		mod_timer(&s->rx_timer, jiffies + port->timeout);
+		return IRQ_HANDLED;
+	}
+#endif
+
 	/* I think sci_receive_chars has to be called irrespective
 	 * of whether the I_IXOFF is set, otherwise, how is the interrupt
 	 * to be disabled?
@@ -800,6 +854,12 @@ static void sci_free_irq(struct sci_port *port)
 static unsigned int sci_tx_empty(struct uart_port *port)
 {
 	unsigned short status = sci_in(port, SCxSR);
+
+#ifdef CONFIG_SERIAL_SH_SCI_DMA
+	if (to_sci_port(port)->cookie_tx >= 0)
+		return 0;
+#endif
+
 	return status & SCxSR_TEND(port) ? TIOCSER_TEMT : 0;
 }
 
@@ -822,6 +882,18 @@ static void sci_start_tx(struct uart_port *port)
 {
 	unsigned short ctrl;
 
+#ifdef CONFIG_SERIAL_SH_SCI_DMA
+	struct sci_port *s = to_sci_port(port);
+
+	if (s->chan_tx) {
+		/* shdma can't be called with interrupts off, defer the submit */
+		if (s->cookie_tx < 0 &&
+		    (!uart_circ_empty(&port->state->xmit) || port->x_char))
+			schedule_work(&s->work_tx);
+		return;
+	}
+#endif
+
 	/* Set TIE (Transmit Interrupt Enable) bit in SCSCR */
 	ctrl = sci_in(port, SCSCR);
 	ctrl |= SCI_CTRL_FLAGS_TIE;
@@ -868,6 +940,407 @@ static void sci_break_ctl(struct uart_port *port, int break_state)
 	/* Nothing here yet .. */
 }
 
+#ifdef CONFIG_SERIAL_SH_SCI_DMA
+/*
+ * Size of each of the two Rx DMA buffers. Partially filled buffers are
+ * pushed out by the Rx timer, so this only bounds the completion rate.
+ */
+#define SCI_DMA_RX_BUF_LEN	256
+
+static void sci_dma_tx_complete(void *arg)
+{
+	struct sci_port *s = arg;
+	struct uart_port *port = &s->port;
+	struct circ_buf *xmit = &port->state->xmit;
+	unsigned long flags;
+
+	spin_lock_irqsave(&port->lock, flags);
+
+	s->cookie_tx = -EINVAL;
+
+	if (s->chan_tx) {
+		xmit->tail += s->sg_len_tx;
+		xmit->tail &= UART_XMIT_SIZE - 1;
+		port->icount.tx += s->sg_len_tx;
+
+		if (uart_circ_chars_pending(xmit) < WAKEUP_CHARS)
+			uart_write_wakeup(port);
+
+		if (!uart_circ_empty(xmit) || port->x_char)
+			schedule_work(&s->work_tx);
+	}
+
+	spin_unlock_irqrestore(&port->lock, flags);
+}
+
+/*
+ * Called by uart_flush_buffer() with port->lock held, right after the
+ * xmit buffer has been reset. A transfer still in flight must not move
+ * the new tail when it completes.
+ */
+static void sci_flush_buffer(struct uart_port *port)
+{
+	struct sci_port *s = to_sci_port(port);
+
+	s->sg_len_tx = 0;
+}
+
+/* Called from the Tx work or on shutdown, not under port->lock */
+static void sci_tx_dma_release(struct sci_port *s, bool enable_pio)
+{
+	struct dma_chan *chan = s->chan_tx;
+	struct uart_port *port = &s->port;
+	unsigned long flags;
+
+	spin_lock_irqsave(&port->lock, flags);
+	s->chan_tx = NULL;
+	s->cookie_tx = -EINVAL;
+	spin_unlock_irqrestore(&port->lock, flags);
+
+	chan->device->device_terminate_all(chan);
+	dma_unmap_single(chan->device->dev, s->buf_tx_dma, UART_XMIT_SIZE,
+			 DMA_TO_DEVICE);
+	dma_release_channel(chan);
+
+	if (enable_pio) {
+		spin_lock_irqsave(&port->lock, flags);
+		sci_start_tx(port);
+		spin_unlock_irqrestore(&port->lock, flags);
+	}
+}
+
+static void sci_dma_tx_work_fn(struct work_struct *work)
+{
+	struct sci_port *s = container_of(work, struct sci_port, work_tx);
+	struct dma_async_tx_descriptor *desc;
+	struct uart_port *port = &s->port;
+	struct circ_buf *xmit = &port->state->xmit;
+	struct scatterlist *sg = &s->sg_tx;
+	struct dma_chan *chan = s->chan_tx;
+	dma_cookie_t cookie;
+	unsigned int tail;
+
+	if (!chan)
+		return;
+
+	spin_lock_irq(&port->lock);
+
+	if (s->cookie_tx >= 0)
+		goto out;
+
+	/* Nothing is in flight, so XON/XOFF can't overtake queued data */
+	if (port->x_char && scif_txroom(port) > 0) {
+		sci_out(port, SCxTDR, port->x_char);
+		port->x_char = 0;
+		port->icount.tx++;
+	}
+
+	tail = xmit->tail;
+	s->sg_len_tx = CIRC_CNT_TO_END(xmit->head, tail, UART_XMIT_SIZE);
+	if (!s->sg_len_tx || uart_tx_stopped(port))
+		goto out;
+
+	sg_dma_address(sg) = s->buf_tx_dma + tail;
+	sg_dma_len(sg) = s->sg_len_tx;
+
+	/* Claim the channel, sci_start_tx() won't queue us again */
+	s->cookie_tx = 0;
+
+	spin_unlock_irq(&port->lock);
+
+	dma_sync_single_range_for_device(chan->device->dev, s->buf_tx_dma,
+					 tail, s->sg_len_tx, DMA_TO_DEVICE);
+
+	desc = chan->device->device_prep_slave_sg(chan, sg, 1, DMA_TO_DEVICE,
+					DMA_PREP_INTERRUPT | DMA_CTRL_ACK);
+	if (!desc)
+		goto fail;
+
+	desc->callback = sci_dma_tx_complete;
+	desc->callback_param = s;
+	cookie = desc->tx_submit(desc);
+	if (cookie < 0)
+		goto fail;
+
+	spin_lock_irq(&port->lock);
+	/* Unless the transfer has completed already */
+	if (!s->cookie_tx)
+		s->cookie_tx = cookie;
+	spin_unlock_irq(&port->lock);
+
+	dma_async_issue_pending(chan);
+	return;
+
+out:
+	spin_unlock_irq(&port->lock);
+	return;
+
+fail:
+	dev_warn(port->dev, "failed to queue Tx DMA, falling back to PIO\n");
+	sci_tx_dma_release(s, true);
+}
+
+static int sci_dma_rx_push(struct sci_port *s, struct tty_struct *tty,
+			   int i, size_t count)
+{
+	struct uart_port *port = &s->port;
+	int copied;
+
+	copied = tty_insert_flip_string(tty,
+			s->buf_rx + i * SCI_DMA_RX_BUF_LEN, count);
+	if (copied < count)
+		port->icount.buf_overrun += count - copied;
+	port->icount.rx += copied;
+
+	return copied;
+}
+
+static void sci_dma_rx_complete(void *arg)
+{
+	struct sci_port *s = arg;
+	struct uart_port *port = &s->port;
+	struct tty_struct *tty = port->state->port.tty;
+	unsigned long flags;
+	int count = 0;
+
+	spin_lock_irqsave(&port->lock, flags);
+
+	/* Buffers complete in the order they were submitted */
+	if (s->chan_rx)
+		count = sci_dma_rx_push(s, tty, s->active_rx,
+					SCI_DMA_RX_BUF_LEN);
+	s->cookie_rx[s->active_rx] = -EINVAL;
+	s->active_rx = !s->active_rx;
+
+	spin_unlock_irqrestore(&port->lock, flags);
+
+	if (count)
+		tty_flip_buffer_push(tty);
+
+	schedule_work(&s->work_rx);
+}
+
+/* Called from the Rx work or on shutdown, not under port->lock */
+static void sci_rx_dma_release(struct sci_port *s, bool enable_pio)
+{
+	struct dma_chan *chan = s->chan_rx;
+	struct uart_port *port = &s->port;
+	unsigned long flags;
+
+	spin_lock_irqsave(&port->lock, flags);
+	s->chan_rx = NULL;
+	spin_unlock_irqrestore(&port->lock, flags);
+
+	del_timer(&s->rx_timer);
+	chan->device->device_terminate_all(chan);
+	dma_free_coherent(chan->device->dev, 2 * SCI_DMA_RX_BUF_LEN,
+			  s->buf_rx, s->buf_rx_dma);
+	dma_release_channel(chan);
+
+	if (enable_pio)
+		sci_start_rx(port, 0);
+}
+
+/*
+ * Keep both Rx buffers queued. Submission must alternate between them,
+ * sci_dma_rx_complete() relies on it to know which one has completed.
+ */
+static void sci_dma_rx_submit(struct sci_port *s)
+{
+	struct dma_async_tx_descriptor *desc;
+	struct uart_port *port = &s->port;
+	struct dma_chan *chan = s->chan_rx;
+	unsigned long flags;
+	dma_cookie_t cookie;
+	int i;
+
+	for (;;) {
+		spin_lock_irqsave(&port->lock, flags);
+		i = s->next_rx;
+		if (s->cookie_rx[i] >= 0) {
+			spin_unlock_irqrestore(&port->lock, flags);
+			break;
+		}
+		s->cookie_rx[i] = 0;
+		s->next_rx = !i;
+		spin_unlock_irqrestore(&port->lock, flags);
+
+		desc = chan->device->device_prep_slave_sg(chan, &s->sg_rx[i],
+				1, DMA_FROM_DEVICE,
+				DMA_PREP_INTERRUPT | DMA_CTRL_ACK);
+		if (!desc)
+			goto fail;
+
+		desc->callback = sci_dma_rx_complete;
+		desc->callback_param = s;
+		cookie = desc->tx_submit(desc);
+		if (cookie < 0)
+			goto fail;
+
+		spin_lock_irqsave(&port->lock, flags);
+		s->desc_rx[i] = desc;
+		/* Unless the buffer has been filled already */
+		if (!s->cookie_rx[i])
+			s->cookie_rx[i] = cookie;
+		spin_unlock_irqrestore(&port->lock, flags);
+	}
+
+	dma_async_issue_pending(chan);
+	return;
+
+fail:
+	dev_warn(port->dev, "failed to queue Rx DMA, falling back to PIO\n");
+	sci_rx_dma_release(s, true);
+}
+
+static void sci_dma_rx_work_fn(struct work_struct *work)
+{
+	struct sci_port *s = container_of(work, struct sci_port, work_rx);
+	struct uart_port *port = &s->port;
+	struct tty_struct *tty = port->state->port.tty;
+	struct dma_chan *chan = s->chan_rx;
+	unsigned long flags;
+	bool flush;
+	int count = 0;
+
+	if (!chan)
+		return;
+
+	spin_lock_irqsave(&port->lock, flags);
+	flush = s->rx_flush;
+	s->rx_flush = false;
+	spin_unlock_irqrestore(&port->lock, flags);
+
+	if (flush) {
+		/* Runs the callbacks of buffers that did fill up first */
+		chan->device->device_terminate_all(chan);
+
+		spin_lock_irqsave(&port->lock, flags);
+		if (s->cookie_rx[s->active_rx] > 0)
+			count = sci_dma_rx_push(s, tty, s->active_rx,
+				sh_dmae_get_partial(s->desc_rx[s->active_rx]));
+		s->cookie_rx[0] = s->cookie_rx[1] = -EINVAL;
+		s->active_rx = s->next_rx = 0;
+
+		/* Wait for the next burst of data */
+		sci_out(port, SCSCR, sci_in(port, SCSCR) | SCI_CTRL_FLAGS_RIE);
+		spin_unlock_irqrestore(&port->lock, flags);
+
+		if (count)
+			tty_flip_buffer_push(tty);
+	}
+
+	sci_dma_rx_submit(s);
+}
+
+static void sci_rx_timer(unsigned long data)
+{
+	struct sci_port *s = (struct sci_port *)data;
+	unsigned long flags;
+
+	spin_lock_irqsave(&s->port.lock, flags);
+	s->rx_flush = true;
+	spin_unlock_irqrestore(&s->port.lock, flags);
+
+	schedule_work(&s->work_rx);
+}
+
+static bool sci_dma_filter(struct dma_chan *chan, void *arg)
+{
+	dev_dbg(chan->device->dev, "%s: slave data %p\n", __func__, arg);
+	chan->private = arg;
+	return true;
+}
+
+static void sci_request_dma(struct uart_port *port)
+{
+	struct sci_port *s = to_sci_port(port);
+	dma_cap_mask_t mask;
+	struct dma_chan *chan;
+	int i;
+
+	dma_cap_zero(mask);
+	dma_cap_set(DMA_SLAVE, mask);
+
+	if (s->slave_tx > 0) {
+		s->param_tx.slave_id = s->slave_tx;
+		chan = dma_request_channel(mask, sci_dma_filter, &s->param_tx);
+		if (chan) {
+			s->buf_tx_dma = dma_map_single(chan->device->dev,
+						       port->state->xmit.buf,
+						       UART_XMIT_SIZE,
+						       DMA_TO_DEVICE);
+			sg_init_table(&s->sg_tx, 1);
+			s->cookie_tx = -EINVAL;
+			INIT_WORK(&s->work_tx, sci_dma_tx_work_fn);
+			s->chan_tx = chan;
+		}
+	}
+
+	if (s->slave_rx > 0) {
+		s->param_rx.slave_id = s->slave_rx;
+		chan = dma_request_channel(mask, sci_dma_filter, &s->param_rx);
+		if (!chan)
+			goto out;
+
+		s->buf_rx = dma_alloc_coherent(chan->device->dev,
+					       2 * SCI_DMA_RX_BUF_LEN,
+					       &s->buf_rx_dma, GFP_KERNEL);
+		if (!s->buf_rx) {
+			dma_release_channel(chan);
+			goto out;
+		}
+
+		for (i = 0; i < 2; i++) {
+			sg_init_table(&s->sg_rx[i], 1);
+			sg_dma_address(&s->sg_rx[i]) = s->buf_rx_dma +
+				i * SCI_DMA_RX_BUF_LEN;
+			sg_dma_len(&s->sg_rx[i]) = SCI_DMA_RX_BUF_LEN;
+			s->cookie_rx[i] = -EINVAL;
+		}
+		s->active_rx = s->next_rx = 0;
+		s->rx_flush = false;
+		INIT_WORK(&s->work_rx, sci_dma_rx_work_fn);
+		setup_timer(&s->rx_timer, sci_rx_timer, (unsigned long)s);
+		s->chan_rx = chan;
+
+		sci_dma_rx_submit(s);
+	}
+
+out:
+	if (s->chan_tx || s->chan_rx)
+		dev_info(port->dev, "using DMA channels %s (Tx), %s (Rx)\n",
+			 s->chan_tx ? dma_chan_name(s->chan_tx) : "none",
+			 s->chan_rx ? dma_chan_name(s->chan_rx) : "none");
+}
+
+static void sci_release_dma(struct uart_port *port)
+{
+	struct sci_port *s = to_sci_port(port);
+
+	if (s->chan_rx) {
+		del_timer_sync(&s->rx_timer);
+		cancel_work_sync(&s->work_rx);
+		sci_rx_dma_release(s, false);
+	}
+
+	if (s->chan_tx) {
+		cancel_work_sync(&s->work_tx);
+		sci_tx_dma_release(s, false);
+	}
+}
+#else
+static inline void sci_request_dma(struct uart_port *port)
+{
+}
+
+static inline void sci_release_dma(struct uart_port *port)
+{
+}
+
+#define sci_flush_buffer	NULL
+#endif
+
 static int sci_startup(struct uart_port *port)
 {
 	struct sci_port *s = to_sci_port(port);
@@ -876,6 +1349,7 @@ static int sci_startup(struct uart_port *port)
 		s->enable(port);
 
 	sci_request_irq(s);
+	sci_request_dma(port);
 	sci_start_tx(port);
 	sci_start_rx(port, 1);
 
@@ -888,6 +1362,7 @@ static void sci_shutdown(struct uart_port *port)
 
 	sci_stop_rx(port);
 	sci_stop_tx(port);
+	sci_release_dma(port);
 	sci_free_irq(s);
 
 	if (s->disable)
@@ -1033,6 +1508,7 @@ static struct uart_ops sci_uart_ops = {
 	.startup	= sci_startup,
 	.shutdown	= sci_shutdown,
 	.set_termios	= sci_set_termios,
+	.flush_buffer	= sci_flush_buffer,
 	.type		= sci_type,
 	.release_port	= sci_release_port,
 	.request_port	= sci_request_port,
@@ -1085,6 +1561,15 @@ static void __devinit sci_init_single(struct platform_device *dev,
 	sci_port->type		= sci_port->port.type = p->type;
 
 	memcpy(&sci_port->irqs, &p->irqs, sizeof(p->irqs));
+
+#ifdef CONFIG_SERIAL_SH_SCI_DMA
+	/* The SCI has no FIFO the DMAC could work on */
+	if (p->type != PORT_SCI) {
+		sci_port->slave_tx = p->dma_slave_tx;
+		sci_port->slave_rx = p->dma_slave_rx;
+	}
+	sci_port->cookie_tx = -EINVAL;
+#endif
 }
 
 #ifdef CONFIG_SERIAL_SH_SCI_CONSOLE
@@ -20,6 +20,13 @@
 #include <linux/bitmap.h>
 #include <linux/clk.h>
 #include <linux/io.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/dmaengine.h>
+#include <linux/dma-mapping.h>
+#include <linux/scatterlist.h>
 
 #include <linux/spi/spi.h>
 #include <linux/spi/spi_bitbang.h>
@@ -27,6 +34,18 @@
 
 #include <asm/spi.h>
 #include <asm/unaligned.h>
+#ifdef CONFIG_SPI_SH_MSIOF_DMA
+#include <asm/dma-sh.h>
+#endif
+
+struct sh_msiof_spi_stats {
+	unsigned long pio_xfers;
+	unsigned long dma_xfers;
+	u64 pio_bytes;
+	u64 dma_bytes;
+	u64 pio_ns;
+	u64 dma_ns;
+};
 
 struct sh_msiof_spi_priv {
 	struct spi_bitbang bitbang; /* must be first for spi_bitbang.c */
@@ -38,6 +57,18 @@ struct sh_msiof_spi_priv {
 	unsigned long flags;
 	int tx_fifo_size;
 	int rx_fifo_size;
+	struct sh_msiof_spi_stats stats;
+	struct dentry *debugfs;
+#ifdef CONFIG_SPI_SH_MSIOF_DMA
+	struct sh_dmae_slave param_tx;
+	struct sh_dmae_slave param_rx;
+	struct dma_chan *chan_tx;
+	struct dma_chan *chan_rx;
+	void *tx_dma_buf;		/* two chunks each, see sh_msiof_dma_* */
+	void *rx_dma_buf;
+	dma_addr_t tx_dma_addr;
+	dma_addr_t rx_dma_addr;
+#endif
 };
 
 #define TMDR1	0x00
@@ -67,6 +98,11 @@ struct sh_msiof_spi_priv {
 #define STR_TEOF  (1 << 23)
 #define STR_REOF  (1 << 7)
 
+#define IER_TDMAE  (1 << 31)
+#define IER_TDREQE (1 << 28)
+#define IER_RDMAE  (1 << 15)
+#define IER_RDREQE (1 << 12)
+
 static unsigned long sh_msiof_read(struct sh_msiof_spi_priv *p, int reg_offs)
 {
 	switch (reg_offs) {
@@ -458,16 +494,390 @@ static int sh_msiof_spi_txrx_once(struct sh_msiof_spi_priv *p,
 	return ret;
 }
 
+#ifdef CONFIG_SPI_SH_MSIOF_DMA
+/* Shorter transfers are cheaper to do by PIO than to set up DMA for */
+#define SH_MSIOF_DMA_MIN_LEN	128
+
+/* A frame carries up to 256 words, the DMAC always moves 32-bit words */
+#define SH_MSIOF_DMA_CHUNK	(256 * 4)
+
+/*
+ * 8 and 16 bit SPI words are packed into 32 bit FIFO words, first word
+ * in the most significant bits as that is the one which goes out first.
+ */
+static void sh_msiof_dma_pack(u32 *dst, const void *src, int bytes, int bits)
+{
+	const u8 *buf = src;
+	int k;
+
+	switch (bits) {
+	case 8:
+		for (k = 0; k < bytes / 4; k++, buf += 4)
+			dst[k] = get_unaligned_be32(buf);
+		break;
+	case 16:
+		for (k = 0; k < bytes / 4; k++, buf += 4)
+			dst[k] = (u32)get_unaligned((u16 *)buf) << 16 |
+				 get_unaligned((u16 *)(buf + 2));
+		break;
+	default:
+		for (k = 0; k < bytes / 4; k++, buf += 4)
+			dst[k] = get_unaligned((u32 *)buf);
+		break;
+	}
+}
+
+static void sh_msiof_dma_unpack(void *dst, const u32 *src, int bytes, int bits)
+{
+	u8 *buf = dst;
+	int k;
+
+	switch (bits) {
+	case 8:
+		for (k = 0; k < bytes / 4; k++, buf += 4)
+			put_unaligned_be32(src[k], buf);
+		break;
+	case 16:
+		for (k = 0; k < bytes / 4; k++, buf += 4) {
+			put_unaligned(src[k] >> 16, (u16 *)buf);
+			put_unaligned(src[k] & 0xffff, (u16 *)(buf + 2));
+		}
+		break;
+	default:
+		for (k = 0; k < bytes / 4; k++, buf += 4)
+			put_unaligned(src[k], (u32 *)buf);
+		break;
+	}
+}
+
+static void sh_msiof_dma_complete(void *arg)
+{
+	struct sh_msiof_spi_priv *p = arg;
+
+	complete(&p->done);
+}
+
+static void sh_msiof_dma_terminate(struct sh_msiof_spi_priv *p)
+{
+	p->chan_rx->device->device_terminate_all(p->chan_rx);
+	p->chan_tx->device->device_terminate_all(p->chan_tx);
+}
+
+/* Start moving one chunk from/to half @buf of the bounce buffers */
+static int sh_msiof_dma_start(struct sh_msiof_spi_priv *p, int buf,
+			      bool tx, bool rx, int words)
+{
+	struct dma_async_tx_descriptor *desc_tx = NULL, *desc_rx = NULL;
+	struct scatterlist sg;
+	unsigned long ier_bits = 0;
+	int len = words * 4;
+	int ret;
+
+	if (rx) {
+		sg_init_table(&sg, 1);
+		sg_dma_address(&sg) = p->rx_dma_addr + buf * SH_MSIOF_DMA_CHUNK;
+		sg_dma_len(&sg) = len;
+		desc_rx = p->chan_rx->device->device_prep_slave_sg(p->chan_rx,
+					&sg, 1, DMA_FROM_DEVICE,
+					DMA_PREP_INTERRUPT | DMA_CTRL_ACK);
+		if (!desc_rx)
+			return -EAGAIN;
+
+		/* Reception ends last, so it signals the end of the chunk */
+		desc_rx->callback = sh_msiof_dma_complete;
+		desc_rx->callback_param = p;
+		ier_bits |= IER_RDREQE | IER_RDMAE;
+	}
+
+	if (tx) {
+		dma_sync_single_range_for_device(p->chan_tx->device->dev,
+						 p->tx_dma_addr,
+						 buf * SH_MSIOF_DMA_CHUNK, len,
+						 DMA_TO_DEVICE);
+		sg_init_table(&sg, 1);
+		sg_dma_address(&sg) = p->tx_dma_addr + buf * SH_MSIOF_DMA_CHUNK;
+		sg_dma_len(&sg) = len;
+		desc_tx = p->chan_tx->device->device_prep_slave_sg(p->chan_tx,
+					&sg, 1, DMA_TO_DEVICE,
+					rx ? DMA_CTRL_ACK :
+					DMA_PREP_INTERRUPT | DMA_CTRL_ACK);
+		if (!desc_tx) {
+			ret = -EAGAIN;
+			goto err;
+		}
+
+		if (!rx) {
+			desc_tx->callback = sh_msiof_dma_complete;
+			desc_tx->callback_param = p;
+		}
+		ier_bits |= IER_TDREQE | IER_TDMAE;
+	}
+
+	/* setup msiof transfer mode registers, 32 bit words for the DMAC */
+	sh_msiof_spi_set_mode_regs(p, tx ? p->tx_dma_buf : NULL,
+				   rx ? p->rx_dma_buf : NULL, 32, words);
+	sh_msiof_write(p, IER, ier_bits);
+
+	INIT_COMPLETION(p->done);
+	if (rx) {
+		desc_rx->tx_submit(desc_rx);
+		dma_async_issue_pending(p->chan_rx);
+	}
+	if (tx) {
+		desc_tx->tx_submit(desc_tx);
+		dma_async_issue_pending(p->chan_tx);
+	}
+
+	/* setup clock and rx/tx signals, start by setting frame bit */
+	ret = sh_msiof_modify_ctr_wait(p, 0, CTR_TSCKE);
+	if (rx)
+		ret = ret ? ret : sh_msiof_modify_ctr_wait(p, 0, CTR_RXE);
+	ret = ret ? ret : sh_msiof_modify_ctr_wait(p, 0, CTR_TXE);
+	ret = ret ? ret : sh_msiof_modify_ctr_wait(p, 0, CTR_TFSE);
+	if (ret) {
+		dev_err(&p->pdev->dev, "failed to start hardware\n");
+		goto err;
+	}
+
+	return 0;
+
+ err:
+	sh_msiof_write(p, IER, 0);
+	sh_msiof_dma_terminate(p);
+	return ret;
+}
+
+/* Wait for the chunk started by sh_msiof_dma_start() and stop the hardware */
+static int sh_msiof_dma_wait(struct sh_msiof_spi_priv *p, int buf,
+			     bool tx, bool rx, int words)
+{
+	int ret = 0;
+	int err;
+
+	if (!wait_for_completion_timeout(&p->done, HZ))
+		ret = -ETIMEDOUT;
+
+	/* With Tx only, DMA completes as soon as the FIFO has been loaded */
+	if (!ret && !rx) {
+		INIT_COMPLETION(p->done);
+		sh_msiof_write(p, IER, STR_TEOF);
+		if (!wait_for_completion_timeout(&p->done, HZ))
+			ret = -ETIMEDOUT;
+	}
+
+	sh_msiof_write(p, IER, 0);
+	if (ret) {
+		dev_err(&p->pdev->dev, "DMA transfer timed out\n");
+		sh_msiof_dma_terminate(p);
+	}
+
+	/* clear status bits */
+	sh_msiof_reset_str(p);
+
+	/* shut down frame, tx/tx and clock signals */
+	err = sh_msiof_modify_ctr_wait(p, CTR_TFSE, 0);
+	err = err ? err : sh_msiof_modify_ctr_wait(p, CTR_TXE, 0);
+	if (rx)
+		err = err ? err : sh_msiof_modify_ctr_wait(p, CTR_RXE, 0);
+	err = err ? err : sh_msiof_modify_ctr_wait(p, CTR_TSCKE, 0);
+	if (err)
+		dev_err(&p->pdev->dev, "failed to shut down hardware\n");
+	if (ret || err)
+		return ret ? ret : err;
+
+	if (rx)
+		dma_sync_single_range_for_cpu(p->chan_rx->device->dev,
+					      p->rx_dma_addr,
+					      buf * SH_MSIOF_DMA_CHUNK,
+					      words * 4, DMA_FROM_DEVICE);
+	return 0;
+}
+
+/*
+ * Move @len bytes (a multiple of 4) through the bounce buffers. They are
+ * double buffered: while the DMAC moves one chunk, the CPU packs the next
+ * Tx chunk and unpacks the previous Rx chunk. Returns the number of bytes
+ * transferred in @done; -EAGAIN means the rest may still be done by PIO.
+ */
+static int sh_msiof_spi_txrx_dma(struct sh_msiof_spi_priv *p,
+				 struct spi_transfer *t, int bits, int len,
+				 int *done)
+{
+	const void *tx_buf = t->tx_buf;
+	void *rx_buf = t->rx_buf;
+	int cur = 0, prev = 0;
+	int ret = 0;
+	int n;
+
+	*done = 0;
+
+	if (tx_buf)
+		sh_msiof_dma_pack(p->tx_dma_buf, tx_buf,
+				  min(len, SH_MSIOF_DMA_CHUNK), bits);
+
+	while (*done < len) {
+		n = min(len - *done, SH_MSIOF_DMA_CHUNK);
+
+		ret = sh_msiof_dma_start(p, cur, tx_buf, rx_buf, n / 4);
+		if (ret)
+			break;
+
+		if (tx_buf && *done + n < len)
+			sh_msiof_dma_pack(p->tx_dma_buf + !cur * SH_MSIOF_DMA_CHUNK,
+					  tx_buf + *done + n,
+					  min(len - *done - n, SH_MSIOF_DMA_CHUNK),
+					  bits);
+		if (rx_buf && prev) {
+			sh_msiof_dma_unpack(rx_buf + *done - prev,
+					    p->rx_dma_buf + !cur * SH_MSIOF_DMA_CHUNK,
+					    prev, bits);
+			prev = 0;
+		}
+
+		ret = sh_msiof_dma_wait(p, cur, tx_buf, rx_buf, n / 4);
+		if (ret)
+			break;
+
+		*done += n;
+		prev = n;
+		cur = !cur;
+	}
+
+	/* The last chunk (or the one before a failed start) is still unread */
+	if (rx_buf && prev)
+		sh_msiof_dma_unpack(rx_buf + *done - prev,
+				    p->rx_dma_buf + !cur * SH_MSIOF_DMA_CHUNK,
+				    prev, bits);
+
+	return ret;
+}
+
+static bool sh_msiof_spi_can_dma(struct sh_msiof_spi_priv *p,
+				 struct spi_device *spi, int bits, int len)
+{
+	if (!p->chan_tx || len < SH_MSIOF_DMA_MIN_LEN)
+		return false;
+
+	/* Packed words only come out right MSB first */
+	if (spi->mode & SPI_LSB_FIRST)
+		return false;
+
+	return bits == 8 || bits == 16 || bits == 32;
+}
+
+static bool sh_msiof_dma_filter(struct dma_chan *chan, void *arg)
+{
+	dev_dbg(chan->device->dev, "%s: slave data %p\n", __func__, arg);
+	chan->private = arg;
+	return true;
+}
+
+static void sh_msiof_request_dma(struct sh_msiof_spi_priv *p)
+{
+	dma_cap_mask_t mask;
+
+	/* We can only either use DMA for both Tx and Rx or not use it at all */
+	if (p->info->dma_slave_tx <= 0 || p->info->dma_slave_rx <= 0)
+		return;
+
+	dma_cap_zero(mask);
+	dma_cap_set(DMA_SLAVE, mask);
+
+	p->param_tx.slave_id = p->info->dma_slave_tx;
+	p->param_rx.slave_id = p->info->dma_slave_rx;
+
+	p->chan_tx = dma_request_channel(mask, sh_msiof_dma_filter,
+					 &p->param_tx);
+	if (!p->chan_tx)
+		return;
+
+	p->chan_rx = dma_request_channel(mask, sh_msiof_dma_filter,
+					 &p->param_rx);
+	if (!p->chan_rx)
+		goto err0;
+
+	/* Two chunks per direction, one for the CPU and one for the DMAC */
+	p->tx_dma_buf = (void *)__get_free_page(GFP_KERNEL | GFP_DMA);
+	p->rx_dma_buf = (void *)__get_free_page(GFP_KERNEL | GFP_DMA);
+	if (!p->tx_dma_buf || !p->rx_dma_buf)
+		goto err1;
+
+	p->tx_dma_addr = dma_map_single(p->chan_tx->device->dev,
+					p->tx_dma_buf, 2 * SH_MSIOF_DMA_CHUNK,
+					DMA_TO_DEVICE);
+	p->rx_dma_addr = dma_map_single(p->chan_rx->device->dev,
+					p->rx_dma_buf, 2 * SH_MSIOF_DMA_CHUNK,
+					DMA_FROM_DEVICE);
+
+	dev_info(&p->pdev->dev, "using DMA channels %s (Tx), %s (Rx)\n",
+		 dma_chan_name(p->chan_tx), dma_chan_name(p->chan_rx));
+	return;
+
+ err1:
+	free_page((unsigned long)p->rx_dma_buf);
+	free_page((unsigned long)p->tx_dma_buf);
+	dma_release_channel(p->chan_rx);
+	p->chan_rx = NULL;
+ err0:
+	dma_release_channel(p->chan_tx);
+	p->chan_tx = NULL;
+}
+
+static void sh_msiof_release_dma(struct sh_msiof_spi_priv *p)
+{
+	if (!p->chan_tx)
+		return;
+
+	dma_unmap_single(p->chan_rx->device->dev, p->rx_dma_addr,
+			 2 * SH_MSIOF_DMA_CHUNK, DMA_FROM_DEVICE);
+	dma_unmap_single(p->chan_tx->device->dev, p->tx_dma_addr,
+			 2 * SH_MSIOF_DMA_CHUNK, DMA_TO_DEVICE);
+	free_page((unsigned long)p->rx_dma_buf);
+	free_page((unsigned long)p->tx_dma_buf);
+	dma_release_channel(p->chan_rx);
+	dma_release_channel(p->chan_tx);
+	p->chan_rx = NULL;
+	p->chan_tx = NULL;
+}
+#else
+static bool sh_msiof_spi_can_dma(struct sh_msiof_spi_priv *p,
+				 struct spi_device *spi, int bits, int len)
+{
+	return false;
+}
+
+static int sh_msiof_spi_txrx_dma(struct sh_msiof_spi_priv *p,
+				 struct spi_transfer *t, int bits, int len,
+				 int *done)
+{
+	*done = 0;
+	return -EAGAIN;
+}
+
+static void sh_msiof_request_dma(struct sh_msiof_spi_priv *p)
+{
+}
+
+static void sh_msiof_release_dma(struct sh_msiof_spi_priv *p)
+{
+}
+#endif
+
 static int sh_msiof_spi_txrx(struct spi_device *spi, struct spi_transfer *t)
 {
 	struct sh_msiof_spi_priv *p = spi_master_get_devdata(spi->master);
 	void (*tx_fifo)(struct sh_msiof_spi_priv *, const void *, int, int);
 	void (*rx_fifo)(struct sh_msiof_spi_priv *, void *, int, int);
+	struct sh_msiof_spi_stats *stats = &p->stats;
+	ktime_t start = ktime_get();
 	int bits;
 	int bytes_per_word;
 	int bytes_done;
+	int dma_done = 0;
 	int words;
+	int ret;
 	int n;
+	u64 ns;
 
 	bits = sh_msiof_spi_bits(spi, t);
 
@@ -504,14 +914,24 @@ static int sh_msiof_spi_txrx(struct spi_device *spi, struct spi_transfer *t)
 	sh_msiof_spi_set_clk_regs(p, clk_get_rate(p->clk),
 				  sh_msiof_spi_hz(spi, t));
 
-	/* transfer in fifo sized chunks */
-	words = t->len / bytes_per_word;
-	bytes_done = 0;
+	/* large transfers go through the DMAC, whole 32 bit words only */
+	if (sh_msiof_spi_can_dma(p, spi, bits, t->len)) {
+		ret = sh_msiof_spi_txrx_dma(p, t, bits, t->len & ~3,
+					    &dma_done);
+		if (ret && ret != -EAGAIN) {
+			bytes_done = dma_done;
+			goto out;
+		}
+	}
+
+	/* transfer the rest in fifo sized chunks */
+	words = (t->len - dma_done) / bytes_per_word;
+	bytes_done = dma_done;
 
 	while (bytes_done < t->len) {
 		n = sh_msiof_spi_txrx_once(p, tx_fifo, rx_fifo,
-					   t->tx_buf + bytes_done,
-					   t->rx_buf + bytes_done,
+					   t->tx_buf ? t->tx_buf + bytes_done : NULL,
+					   t->rx_buf ? t->rx_buf + bytes_done : NULL,
 					   words, bits);
 		if (n < 0)
 			break;
@@ -520,6 +940,18 @@ static int sh_msiof_spi_txrx(struct spi_device *spi, struct spi_transfer *t)
 		words -= n;
 	}
 
+ out:
+	ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+	if (dma_done) {
+		stats->dma_xfers++;
+		stats->dma_bytes += bytes_done;
+		stats->dma_ns += ns;
+	} else {
+		stats->pio_xfers++;
+		stats->pio_bytes += bytes_done;
+		stats->pio_ns += ns;
+	}
+
 	return bytes_done;
 }
 
@@ -530,6 +962,64 @@ static u32 sh_msiof_spi_txrx_word(struct spi_device *spi, unsigned nsecs,
 	return 0;
 }
 
+#ifdef CONFIG_DEBUG_FS
+static u64 sh_msiof_spi_kib_per_sec(u64 bytes, u64 ns)
+{
+	return ns ? div64_u64(bytes * (NSEC_PER_SEC / 1024), ns) : 0;
+}
+
+static int sh_msiof_spi_stats_show(struct seq_file *s, void *unused)
+{
+	struct sh_msiof_spi_priv *p = s->private;
+	struct sh_msiof_spi_stats *stats = &p->stats;
+
+	seq_printf(s, "pio: %lu transfers, %llu bytes, %llu KiB/s\n",
+		   stats->pio_xfers, stats->pio_bytes,
+		   sh_msiof_spi_kib_per_sec(stats->pio_bytes, stats->pio_ns));
+	seq_printf(s, "dma: %lu transfers, %llu bytes, %llu KiB/s\n",
+		   stats->dma_xfers, stats->dma_bytes,
+		   sh_msiof_spi_kib_per_sec(stats->dma_bytes, stats->dma_ns));
+
+	return 0;
+}
+
+static int sh_msiof_spi_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, sh_msiof_spi_stats_show, inode->i_private);
+}
+
+static const struct file_operations sh_msiof_spi_stats_fops = {
+	.owner		= THIS_MODULE,
+	.open		= sh_msiof_spi_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static void sh_msiof_spi_debugfs_init(struct sh_msiof_spi_priv *p)
+{
+	p->debugfs = debugfs_create_dir(dev_name(&p->pdev->dev), NULL);
+	if (!p->debugfs)
+		return;
+
+	debugfs_create_file("stats", S_IRUGO, p->debugfs, p,
+			    &sh_msiof_spi_stats_fops);
+}
+
+static void sh_msiof_spi_debugfs_remove(struct sh_msiof_spi_priv *p)
+{
+	debugfs_remove_recursive(p->debugfs);
+}
+#else
+static inline void sh_msiof_spi_debugfs_init(struct sh_msiof_spi_priv *p)
+{
+}
+
+static inline void sh_msiof_spi_debugfs_remove(struct sh_msiof_spi_priv *p)
+{
+}
+#endif /* CONFIG_DEBUG_FS */
+
 static int sh_msiof_spi_probe(struct platform_device *pdev)
 {
 	struct resource	*r;
@@ -612,10 +1102,15 @@ static int sh_msiof_spi_probe(struct platform_device *pdev)
 	p->bitbang.txrx_word[SPI_MODE_2] = sh_msiof_spi_txrx_word;
 	p->bitbang.txrx_word[SPI_MODE_3] = sh_msiof_spi_txrx_word;
 
+	sh_msiof_request_dma(p);
+
 	ret = spi_bitbang_start(&p->bitbang);
-	if (ret == 0)
+	if (ret == 0) {
+		sh_msiof_spi_debugfs_init(p);
 		return 0;
+	}
 
+	sh_msiof_release_dma(p);
 	pm_runtime_disable(&pdev->dev);
  err3:
 	iounmap(p->mapbase);
@@ -634,6 +1129,8 @@ static int sh_msiof_spi_remove(struct platform_device *pdev)
 
 	ret = spi_bitbang_stop(&p->bitbang);
 	if (!ret) {
+		sh_msiof_spi_debugfs_remove(p);
+		sh_msiof_release_dma(p);
 		pm_runtime_disable(&pdev->dev);
 		free_irq(platform_get_irq(pdev, 0), sh_msiof_spi_irq);
 		iounmap(p->mapbase);
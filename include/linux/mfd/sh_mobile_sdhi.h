@@ -1,7 +1,11 @@
 #ifndef __SH_MOBILE_SDHI_H__
 #define __SH_MOBILE_SDHI_H__
 
+struct platform_device;
+
 struct sh_mobile_sdhi_info {
+	int dma_slave_tx;	/* enum sh_dmae_slave_chan_id, 0 for PIO */
+	int dma_slave_rx;
 	void (*set_pwr)(struct platform_device *pdev, int state);
 };
 
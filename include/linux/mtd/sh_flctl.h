@@ -20,9 +20,13 @@
 #ifndef __SH_FLCTL_H__
 #define __SH_FLCTL_H__
 
+#include <linux/completion.h>
 #include <linux/mtd/mtd.h>
 #include <linux/mtd/nand.h>
 #include <linux/mtd/partitions.h>
+#ifdef CONFIG_MTD_NAND_SH_FLCTL_DMA
+#include <asm/dma-sh.h>
+#endif
 
 /* FLCTL registers */
 #define FLCMNCR(f)		(f->reg + 0x0)
@@ -81,6 +85,13 @@
 #define DOCMD2_E	(0x1 << 17)	/* 2nd cmd stage execute */
 #define DOCMD1_E	(0x1 << 16)	/* 1st cmd stage execute */
 
+/* FLINTDMACR control bits */
+#define AC1CLR		(0x1 << 19)	/* ECC FIFO clear */
+#define AC0CLR		(0x1 << 18)	/* Data FIFO clear */
+#define DREQ1EN		(0x1 << 17)	/* ECC FIFO DMA request enable */
+#define DREQ0EN		(0x1 << 16)	/* Data FIFO DMA request enable */
+#define TEINTE		(0x1 << 2)	/* Transfer end interrupt enable */
+
 /* FLTRCR control bits */
 #define TRSTRT		(0x1 << 0)	/* translation start */
 #define TREND		(0x1 << 1)	/* translation end */
@@ -101,7 +112,8 @@ struct sh_flctl {
 	struct platform_device	*pdev;
 	void __iomem		*reg;
 
-	uint8_t	done_buff[2048 + 64];	/* max size 2048 + 64 */
+	/* max size 2048 + 64, in cache lines of its own for the DMAC */
+	uint8_t	done_buff[2048 + 64] ____cacheline_aligned;
 	int	read_bytes;
 	int	index;
 	int	seqin_column;		/* column in SEQIN cmd */
@@ -113,8 +125,23 @@ struct sh_flctl {
 
 	int	hwecc_cant_correct[4];
 
+	int	irq;			/* FLTENDI, < 0 to poll for TREND */
+	struct completion trend;	/* signalled on the transfer end irq */
+#ifdef CONFIG_MTD_NAND_SH_FLCTL_DMA
+	struct sh_dmae_slave param_tx;
+	struct sh_dmae_slave param_rx;
+	struct dma_chan *chan_fifo0_tx;
+	struct dma_chan *chan_fifo0_rx;
+	struct completion dma_done;
+#endif
+#ifdef CONFIG_DEBUG_FS
+	struct dentry *debugfs;
+#endif
+
 	unsigned page_size:1;	/* NAND page size (0 = 512, 1 = 2048) */
 	unsigned hwecc:1;	/* Hardware ECC (0 = disabled, 1 = enabled) */
+	unsigned pio_only:1;	/* Poll, even with DMA and irq available */
+	unsigned write_failed:1; /* Reported by the next status read */
 };
 
 struct sh_flctl_platform_data {
@@ -122,6 +149,9 @@ struct sh_flctl_platform_data {
 	int			nr_parts;
 	unsigned long		flcmncr_val;
 
+	int			dma_slave_tx;	/* enum sh_dmae_slave_chan_id */
+	int			dma_slave_rx;	/* 0 to use PIO only */
+
 	unsigned has_hwecc:1;
 };
 
@@ -26,6 +26,8 @@ struct plat_sci_port {
 	unsigned int	type;			/* SCI / SCIF / IRDA */
 	upf_t		flags;			/* UPF_* flags */
 	char		*clk;			/* clock string */
+	int		dma_slave_tx;		/* enum sh_dmae_slave_chan_id, */
+	int		dma_slave_rx;		/* 0 for PIO */
 };
 
 #endif /* __LINUX_SERIAL_SCI_H */
@@ -5,6 +5,8 @@ struct sh_msiof_spi_info {
 	int tx_fifo_override;
 	int rx_fifo_override;
 	u16 num_chipselect;
+	int dma_slave_tx;	/* enum sh_dmae_slave_chan_id, 0 for PIO */
+	int dma_slave_rx;
 };
 
 #endif /* __SPI_SH_MSIOF_H__ */
@@ -75,6 +75,12 @@
 struct sh_fsi_platform_info {
 	unsigned long porta_flags;
 	unsigned long portb_flags;
+
+	/* enum sh_dmae_slave_chan_id, 0 to use PIO only */
+	int porta_dma_slave_tx;
+	int porta_dma_slave_rx;
+	int portb_dma_slave_tx;
+	int portb_dma_slave_rx;
 };
 
 extern struct snd_soc_dai fsi_soc_dai[2];
@@ -19,6 +19,8 @@
 #include <linux/list.h>
 #include <linux/pm_runtime.h>
 #include <linux/io.h>
+#include <linux/dmaengine.h>
+#include <linux/mm.h>
 #include <sound/core.h>
 #include <sound/pcm.h>
 #include <sound/initval.h>
@@ -26,6 +28,7 @@
 #include <sound/pcm_params.h>
 #include <sound/sh_fsi.h>
 #include <asm/atomic.h>
+#include <asm/dma-sh.h>
 
 #define DO_FMT		0x0000
 #define DOFF_CTL	0x0004
@@ -62,6 +65,7 @@
 /* DOFF_CTL */
 /* DIFF_CTL */
 #define IRQ_HALF	0x00100000
+#define FIFO_DMA	0x00000100
 #define FIFO_CLR	0x00000001
 
 /* DOFF_ST */
@@ -100,6 +104,13 @@ struct fsi_priv {
 	int period_len;
 	int buffer_len;
 	int periods;
+
+#ifdef CONFIG_SND_SOC_SH4_FSI_DMA
+	/* indexed by is_play */
+	struct sh_dmae_slave param[2];
+	struct dma_chan *dma_chan[2];
+	unsigned int dma_running:1;
+#endif
 };
 
 struct fsi_master {
@@ -538,6 +549,166 @@ static irqreturn_t fsi_interrupt(int irq, void *data)
 	return IRQ_HANDLED;
 }
 
+/************************************************************************
+
+
+		dma function
+
+
+************************************************************************/
+#ifdef CONFIG_SND_SOC_SH4_FSI_DMA
+static bool fsi_dma_filter(struct dma_chan *chan, void *arg)
+{
+	chan->private = arg;
+	return true;
+}
+
+static void fsi_dma_request(struct fsi_priv *fsi, int is_play,
+			    struct device *dev)
+{
+	struct sh_fsi_platform_info *info = master->info;
+	dma_cap_mask_t mask;
+	int slave;
+
+	if (fsi_is_port_a(fsi))
+		slave = is_play ? info->porta_dma_slave_tx :
+			info->porta_dma_slave_rx;
+	else
+		slave = is_play ? info->portb_dma_slave_tx :
+			info->portb_dma_slave_rx;
+
+	if (slave <= 0 || fsi->dma_chan[is_play])
+		return;
+
+	dma_cap_zero(mask);
+	dma_cap_set(DMA_SLAVE, mask);
+	dma_cap_set(DMA_CYCLIC, mask);
+
+	fsi->param[is_play].slave_id = slave;
+	fsi->dma_chan[is_play] = dma_request_channel(mask, fsi_dma_filter,
+						     &fsi->param[is_play]);
+	if (fsi->dma_chan[is_play])
+		dev_dbg(dev, "using DMA channel %s (%s)\n",
+			dma_chan_name(fsi->dma_chan[is_play]),
+			is_play ? "Tx" : "Rx");
+}
+
+static void fsi_dma_release(struct fsi_priv *fsi, int is_play)
+{
+	if (fsi->dma_chan[is_play]) {
+		dma_release_channel(fsi->dma_chan[is_play]);
+		fsi->dma_chan[is_play] = NULL;
+	}
+}
+
+static void fsi_dma_complete(void *arg)
+{
+	struct fsi_priv *fsi = arg;
+	struct snd_pcm_substream *substream = fsi->substream;
+
+	/* called from the DMA tasklet once per period */
+	if (substream)
+		snd_pcm_period_elapsed(substream);
+}
+
+static int fsi_dma_start(struct fsi_priv *fsi, int is_play)
+{
+	struct snd_pcm_runtime *runtime = fsi->substream->runtime;
+	struct dma_chan *chan = fsi->dma_chan[is_play];
+	struct dma_async_tx_descriptor *desc;
+	u32 ctrl = is_play ? DOFF_CTL : DIFF_CTL;
+
+	/*
+	 * The DMAC copies the buffer to DODT as is,
+	 * only 32bit samples need no shift, see fsi_data_push()
+	 */
+	if (!chan || frames_to_bytes(runtime, 1) / fsi->chan != 4)
+		return -EINVAL;
+
+	desc = chan->device->device_prep_dma_cyclic(chan, runtime->dma_addr,
+				fsi->buffer_len, fsi->period_len,
+				is_play ? DMA_TO_DEVICE : DMA_FROM_DEVICE);
+	if (!desc)
+		return -EBUSY;
+
+	desc->callback		= fsi_dma_complete;
+	desc->callback_param	= fsi;
+	if (desc->tx_submit(desc) < 0) {
+		chan->device->device_terminate_all(chan);
+		return -EBUSY;
+	}
+
+	/* let the FIFO request the DMAC instead of interrupting us */
+	fsi_reg_mask_set(fsi, ctrl, FIFO_DMA, FIFO_DMA);
+	dma_async_issue_pending(chan);
+	fsi->dma_running = 1;
+
+	return 0;
+}
+
+static int fsi_dma_stop(struct fsi_priv *fsi, int is_play)
+{
+	struct dma_chan *chan = fsi->dma_chan[is_play];
+	u32 ctrl = is_play ? DOFF_CTL : DIFF_CTL;
+
+	if (!fsi->dma_running)
+		return -EINVAL;
+
+	fsi_reg_mask_set(fsi, ctrl, FIFO_DMA, 0);
+	chan->device->device_terminate_all(chan);
+	fsi->dma_running = 0;
+
+	return 0;
+}
+
+static int fsi_dma_pointer(struct fsi_priv *fsi, int is_play,
+			   snd_pcm_uframes_t *frames)
+{
+	struct snd_pcm_runtime *runtime = fsi->substream->runtime;
+	dma_addr_t pos;
+
+	if (!fsi->dma_running)
+		return -EINVAL;
+
+	/* 0 means idle, the end of the buffer means we just wrapped */
+	pos = sh_dmae_get_position(fsi->dma_chan[is_play]) -
+		runtime->dma_addr;
+	if (pos >= fsi->buffer_len)
+		pos = 0;
+
+	/* what the DMAC has moved may still sit in the FIFO */
+	runtime->delay = fsi_get_fifo_residue(fsi, is_play) / fsi->chan;
+	*frames = bytes_to_frames(runtime, pos);
+
+	return 0;
+}
+#else
+static inline void fsi_dma_request(struct fsi_priv *fsi, int is_play,
+				   struct device *dev)
+{
+}
+
+static inline void fsi_dma_release(struct fsi_priv *fsi, int is_play)
+{
+}
+
+static inline int fsi_dma_start(struct fsi_priv *fsi, int is_play)
+{
+	return -EINVAL;
+}
+
+static inline int fsi_dma_stop(struct fsi_priv *fsi, int is_play)
+{
+	return -EINVAL;
+}
+
+static inline int fsi_dma_pointer(struct fsi_priv *fsi, int is_play,
+				  snd_pcm_uframes_t *frames)
+{
+	return -EINVAL;
+}
+#endif
+
 /************************************************************************
 
 
@@ -661,6 +832,9 @@ static int fsi_dai_startup(struct snd_pcm_substream *substream,
 	/* irq setting */
 	fsi_irq_init(fsi, is_play);
 
+	/* fall back to PIO if there is no channel for us */
+	fsi_dma_request(fsi, is_play, dai->dev);
+
 	return ret;
 }
 
@@ -673,6 +847,8 @@ static void fsi_dai_shutdown(struct snd_pcm_substream *substream,
 	fsi_irq_disable(fsi, is_play);
 	fsi_clk_ctrl(fsi, 0);
 
+	fsi_dma_release(fsi, is_play);
+
 	pm_runtime_put_sync(dai->dev);
 }
 
@@ -689,10 +865,13 @@ static int fsi_dai_trigger(struct snd_pcm_substream *substream, int cmd,
 		fsi_stream_push(fsi, substream,
 				frames_to_bytes(runtime, runtime->buffer_size),
 				frames_to_bytes(runtime, runtime->period_size));
+		if (!fsi_dma_start(fsi, is_play))
+			break;
 		ret = is_play ? fsi_data_push(fsi) : fsi_data_pop(fsi);
 		break;
 	case SNDRV_PCM_TRIGGER_STOP:
-		fsi_irq_disable(fsi, is_play);
+		if (fsi_dma_stop(fsi, is_play))
+			fsi_irq_disable(fsi, is_play);
 		fsi_stream_pop(fsi);
 		break;
 	}
@@ -761,8 +940,13 @@ static snd_pcm_uframes_t fsi_pointer(struct snd_pcm_substream *substream)
 {
 	struct snd_pcm_runtime *runtime = substream->runtime;
 	struct fsi_priv *fsi = fsi_get(substream);
+	int is_play = substream->stream == SNDRV_PCM_STREAM_PLAYBACK;
+	snd_pcm_uframes_t frames;
 	long location;
 
+	if (!fsi_dma_pointer(fsi, is_play, &frames))
+		return frames;
+
 	location = (fsi->byte_offset - 1);
 	if (location < 0)
 		location = 0;
@@ -770,12 +954,38 @@ static snd_pcm_uframes_t fsi_pointer(struct snd_pcm_substream *substream)
 	return bytes_to_frames(runtime, location);
 }
 
+#ifdef CONFIG_SND_SOC_SH4_FSI_DMA
+/*
+ * The coherent buffer is uncached and has no struct page behind its
+ * P2 address, so map it the way snd_pcm_lib_mmap_iomem() does.
+ */
+static int fsi_pcm_mmap(struct snd_pcm_substream *substream,
+			struct vm_area_struct *area)
+{
+	unsigned long size = area->vm_end - area->vm_start;
+	unsigned long offset = area->vm_pgoff << PAGE_SHIFT;
+
+	area->vm_page_prot = pgprot_noncached(area->vm_page_prot);
+	area->vm_flags |= VM_IO;
+
+	if (io_remap_pfn_range(area, area->vm_start,
+			       (substream->runtime->dma_addr + offset) >>
+			       PAGE_SHIFT, size, area->vm_page_prot))
+		return -EAGAIN;
+
+	return 0;
+}
+#endif
+
 static struct snd_pcm_ops fsi_pcm_ops = {
 	.open		= fsi_pcm_open,
 	.ioctl		= snd_pcm_lib_ioctl,
 	.hw_params	= fsi_hw_params,
 	.hw_free	= fsi_hw_free,
 	.pointer	= fsi_pointer,
+#ifdef CONFIG_SND_SOC_SH4_FSI_DMA
+	.mmap		= fsi_pcm_mmap,
+#endif
 };
 
 /************************************************************************
@@ -797,6 +1007,18 @@ static int fsi_pcm_new(struct snd_card *card,
 		       struct snd_soc_dai *dai,
 		       struct snd_pcm *pcm)
 {
+#ifdef CONFIG_SND_SOC_SH4_FSI_DMA
+	/*
+	 * The DMAC needs a physically contiguous buffer.
+	 * The default fault based mmap oopses on it, fsi_pcm_ops
+	 * uses fsi_pcm_mmap() instead.
+	 */
+	return snd_pcm_lib_preallocate_pages_for_all(
+		pcm,
+		SNDRV_DMA_TYPE_DEV,
+		snd_dma_dev(fsi_soc_dai[0].dev),
+		PREALLOC_BUFFER, PREALLOC_BUFFER_MAX);
+#else
 	/*
 	 * dont use SNDRV_DMA_TYPE_DEV, since it will oops the SH kernel
 	 * in MMAP mode (i.e. aplay -M)
@@ -806,6 +1028,7 @@ static int fsi_pcm_new(struct snd_card *card,
 		SNDRV_DMA_TYPE_CONTINUOUS,
 		snd_dma_continuous_data(GFP_KERNEL),
 		PREALLOC_BUFFER, PREALLOC_BUFFER_MAX);
+#endif
 }
 
 /************************************************************************